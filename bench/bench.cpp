@@ -0,0 +1,622 @@
+// AtlantisBench, runs the BunnyMark systems headless for a fixed number of
+// frames and writes the timings as json
+//
+// ./AtlantisBench --entities 1000,10000,100000 --frames 600 --out bench.json
+// ./AtlantisBench --baseline bench.json --tolerance 0.1 (exits with 1 on regressions)
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <omp.h>
+
+#include "engine/core.h"
+#include "engine/memoryTracker.h"
+#include "engine/profiling.h"
+#include "engine/renderer/renderer.h"
+#include "nlohmann/json.hpp"
+#include "fmt/core.h"
+
+using namespace Atlantis;
+
+// allocation counting, covers everything that goes through operator new
+static std::atomic<uint64_t> AllocationCount = 0;
+static std::atomic<uint64_t> AllocationBytes = 0;
+
+void *operator new(size_t size)
+{
+    AllocationCount.fetch_add(1, std::memory_order_relaxed);
+    AllocationBytes.fetch_add(size, std::memory_order_relaxed);
+
+    if (void *ptr = std::malloc(size == 0 ? 1 : size))
+    {
+        return ptr;
+    }
+
+    throw std::bad_alloc();
+}
+
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr, size_t) noexcept
+{
+    std::free(ptr);
+}
+
+struct ABenchOptions
+{
+    std::vector<size_t> EntityCounts = {1000, 10000, 100000};
+    int Frames = 600;
+    int WarmupFrames = 60;
+    uint32_t Seed = 1337;
+
+    // fraction of the entities deleted and recreated every frame
+    float Churn = 0.001f;
+    float DeltaTime = 1.0f / 60.0f;
+    int Threads = 0;
+
+    std::string OutPath = "bench.json";
+    std::string BaselinePath = "";
+    float Tolerance = 0.1f;
+    std::string TracePath = "";
+};
+
+// same area the windowed BunnyMark bounces around in
+static const float ScreenWidth = 800.0f;
+static const float ScreenHeight = 450.0f;
+
+// stand-in for SRenderer, does the culling math without touching raylib
+struct SHeadlessRenderer : public ASystem
+{
+    ComponentBitset Mask;
+    std::vector<AEntity *> Entities;
+    uint LastRegistryVersion = -1;
+
+    size_t VisibleCount = 0;
+
+    SHeadlessRenderer()
+    {
+        IsRenderSystem = true;
+        Labels.insert("HeadlessRender");
+    }
+
+    virtual void Process(AWorld *world) override
+    {
+        if (Mask.none())
+        {
+            Mask = world->GetComponentMaskForComponents({"CRenderable", "CPosition", "CColor"});
+        }
+
+        if (world->GetRegistryVersion() != LastRegistryVersion)
+        {
+            LastRegistryVersion = world->GetRegistryVersion();
+            Entities = world->GetEntitiesWithComponents(Mask);
+        }
+
+        VisibleCount = 0;
+        for (AEntity *e : Entities)
+        {
+            if (!e->_isAlive)
+            {
+                continue;
+            }
+
+            CPosition *pos = e->GetComponentOfType<CPosition>();
+            CColor *col = e->GetComponentOfType<CColor>();
+
+            if (pos->x >= -32.0f && pos->x <= ScreenWidth && pos->y >= -32.0f && pos->y <= ScreenHeight && col->col.a > 0)
+            {
+                VisibleCount++;
+            }
+        }
+
+        Stats.EntitiesProcessed = Entities.size();
+    }
+};
+
+struct ABench
+{
+    const ABenchOptions &Options;
+
+    std::mt19937 Random;
+    std::unique_ptr<AWorld> World;
+
+    size_t EntityCount = 0;
+    size_t ChurnPerFrame = 0;
+
+    ABench(const ABenchOptions &options, size_t entityCount)
+        : Options(options)
+        , Random(options.Seed)
+        , World(std::make_unique<AWorld>())
+        , EntityCount(entityCount)
+    {
+        ChurnPerFrame = (size_t)(entityCount * options.Churn);
+    }
+
+    void SetupBunny(AEntity *e)
+    {
+        static const Color cols[] = {RED, GREEN, BLUE, PURPLE, YELLOW};
+        std::uniform_real_distribution<float> x(0.0f, ScreenWidth);
+        std::uniform_real_distribution<float> y(0.0f, ScreenHeight);
+        std::uniform_int_distribution<int> vel(-250, 250);
+        std::uniform_int_distribution<int> col(0, 4);
+
+        CPosition *p = World->NewObject_Internal<CPosition>();
+        p->x = x(Random);
+        p->y = y(Random);
+
+        CColor *c = World->NewObject_Internal<CColor>();
+        c->col = cols[col(Random)];
+
+        CRenderable *r = World->NewObject_Internal<CRenderable>();
+
+        CVelocity *v = World->NewObject_Internal<CVelocity>();
+        v->x = vel(Random);
+        v->y = vel(Random);
+
+        e->AddComponent(p);
+        e->AddComponent(c);
+        e->AddComponent(r);
+        e->AddComponent(v);
+    }
+
+    void Setup()
+    {
+        // pools are sized up front so we measure the systems and not reallocations
+        size_t capacity = EntityCount + ChurnPerFrame * 2 + 64;
+
+        World->RegisterDefault<AEntity>(capacity, capacity);
+        World->RegisterDefault<CPosition>(capacity, capacity);
+        World->RegisterDefault<CColor>(capacity, capacity);
+        World->RegisterDefault<CVelocity>(capacity, capacity);
+        World->RegisterDefault<CRenderable>(capacity, capacity);
+        World->RegisterDefault<CCamera>(16, 16);
+
+        World->SetFixedDeltaTime(Options.DeltaTime);
+
+        for (size_t i = 0; i < EntityCount; i++)
+        {
+            SetupBunny(World->NewObject_Internal<AEntity>());
+        }
+
+        World->RegisterSystem(
+            [](AWorld *world)
+            {
+                world->ForEntitiesWithComponentsParallel(
+                    [world](AEntity *e, CPosition *pos, CVelocity *vel)
+                    {
+                        pos->x += vel->x * world->GetDeltaTime();
+                        pos->y += vel->y * world->GetDeltaTime();
+
+                        if (((pos->x + 16) > ScreenWidth) || ((pos->x + 16) < 0))
+                        {
+                            vel->x *= -1;
+                        }
+                        if (((pos->y + 16) > ScreenHeight) || ((pos->y + 16 - 40) < 0))
+                        {
+                            vel->y *= -1;
+                        }
+                    });
+            },
+            {"Physics"});
+
+        // replaces the fps driven CreateBunny / DeleteBunny systems with a fixed amount
+        World->RegisterSystem(
+            [this](AWorld *world)
+            {
+                const auto &entities = world->GetObjectsByName("AEntity");
+                if (entities.empty())
+                {
+                    return;
+                }
+
+                // a contiguous range so no entity gets queued for deletion twice
+                std::uniform_int_distribution<size_t> pick(0, entities.size() - 1);
+                size_t start = pick(Random);
+                for (size_t i = 0; i < ChurnPerFrame && i < entities.size(); i++)
+                {
+                    AEntity *e = static_cast<AEntity *>(entities[(start + i) % entities.size()].get());
+                    if (!e->_isAlive)
+                    {
+                        continue;
+                    }
+
+                    world->QueueObjectDeletion(e);
+                    world->QueueNewObject<AEntity>([this](AEntity *entity)
+                                                   { SetupBunny(entity); });
+                }
+            },
+            {"Churn"}, {"Physics"});
+
+        World->RegisterSystemTimesliced(
+            std::max<int>(1, EntityCount / 8),
+            [](AWorld *world, ASystem *system)
+            {
+                world->ForEntitiesWithComponents(system, [](AEntity *e, CColor *col)
+                                                 { col->col.r += 1; });
+            },
+            {"ColorCycle"}, {});
+
+        World->RegisterSystem(new SHeadlessRenderer());
+    }
+
+    // main and render thread systems run in lockstep on this thread, which
+    // is what the two threads boil down to anyway and keeps runs reproducible
+    void Frame()
+    {
+        World->ProcessSystems();
+        World->ProcessSystemsRenderThread();
+    }
+};
+
+struct AMemoryUsage
+{
+    size_t Rss = 0;
+    size_t PeakRss = 0;
+};
+
+static AMemoryUsage GetMemoryUsage()
+{
+    AMemoryUsage usage;
+
+#if defined(__linux__)
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line))
+    {
+        std::istringstream stream(line);
+        std::string key;
+        size_t kb = 0;
+        stream >> key >> kb;
+
+        if (key == "VmRSS:")
+        {
+            usage.Rss = kb * 1024;
+        }
+        else if (key == "VmHWM:")
+        {
+            usage.PeakRss = kb * 1024;
+        }
+    }
+#endif
+
+    return usage;
+}
+
+static nlohmann::json SummarizeMs(std::vector<double> samples)
+{
+    if (samples.empty())
+    {
+        return {{"min", 0.0}, {"avg", 0.0}, {"p50", 0.0}, {"p99", 0.0}, {"max", 0.0}};
+    }
+
+    std::sort(samples.begin(), samples.end());
+
+    double total = 0.0;
+    for (double sample : samples)
+    {
+        total += sample;
+    }
+
+    auto percentile = [&samples](int p)
+    {
+        return samples[std::min(samples.size() - 1, (samples.size() * p) / 100)];
+    };
+
+    return {
+        {"min", samples.front()},
+        {"avg", total / samples.size()},
+        {"p50", percentile(50)},
+        {"p99", percentile(99)},
+        {"max", samples.back()}};
+}
+
+static nlohmann::json RunBench(const ABenchOptions &options, size_t entityCount)
+{
+    ABench bench(options, entityCount);
+
+    auto setupStart = std::chrono::steady_clock::now();
+    bench.Setup();
+    auto setupEnd = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < options.WarmupFrames; i++)
+    {
+        bench.Frame();
+    }
+
+    AWorld &world = *bench.World;
+
+    // one sample vector per system, SyncEntities first like GetSystemStats
+    std::vector<ASystem *> systems;
+    for (auto *list : {&world.Systems, &world.SystemsRenderThread})
+    {
+        for (std::unique_ptr<ASystem> &system : *list)
+        {
+            systems.push_back(system.get());
+        }
+    }
+
+    std::vector<double> frameMs;
+    std::vector<double> syncMs;
+    std::vector<std::vector<double>> systemMs(systems.size());
+    std::vector<size_t> systemEntities(systems.size(), 0);
+    frameMs.reserve(options.Frames);
+
+    uint64_t allocationCount = AllocationCount.load();
+    uint64_t allocationBytes = AllocationBytes.load();
+
+    for (int i = 0; i < options.Frames; i++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        bench.Frame();
+        auto end = std::chrono::steady_clock::now();
+
+        frameMs.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+        syncMs.push_back(world.SyncStats.LastMs);
+
+        for (size_t s = 0; s < systems.size(); s++)
+        {
+            systemMs[s].push_back(systems[s]->Stats.LastMs);
+            systemEntities[s] = std::max(systemEntities[s], systems[s]->Stats.EntitiesProcessed);
+        }
+    }
+
+    allocationCount = AllocationCount.load() - allocationCount;
+    allocationBytes = AllocationBytes.load() - allocationBytes;
+
+    nlohmann::json systemsJson = nlohmann::json::array();
+    systemsJson.push_back({{"name", "SyncEntities"}, {"render_thread", false}, {"timesliced", false}, {"ms", SummarizeMs(syncMs)}, {"entities", 0}});
+    for (size_t s = 0; s < systems.size(); s++)
+    {
+        systemsJson.push_back({
+            {"name", systems[s]->GetName()},
+            {"render_thread", systems[s]->IsRenderSystem},
+            {"timesliced", systems[s]->IsTimesliced},
+            {"ms", SummarizeMs(systemMs[s])},
+            {"entities", systemEntities[s]}});
+    }
+
+    size_t poolBytes = 0;
+    nlohmann::json poolsJson = nlohmann::json::array();
+    for (const APoolStats &pool : world.GetPoolStats())
+    {
+        poolBytes += pool.ReservedBytes;
+        poolsJson.push_back({
+            {"name", pool.Name},
+            {"used", pool.Used},
+            {"capacity", pool.Capacity},
+            {"dead", pool.Dead},
+            {"fragmentation", pool.Fragmentation},
+            {"reserved_bytes", pool.ReservedBytes},
+            {"bookkeeping_bytes", pool.BookkeepingBytes}});
+    }
+
+    nlohmann::json tagsJson = nlohmann::json::object();
+    for (size_t i = 0; i < (size_t)EMemoryTag::Count; i++)
+    {
+        AMemoryTagStats stats = AMemoryTracker::GetStats((EMemoryTag)i);
+        tagsJson[AMemoryTracker::GetTagName((EMemoryTag)i)] = {{"live_bytes", stats.LiveBytes}, {"peak_bytes", stats.PeakBytes}};
+    }
+
+    size_t alive = world.GetObjectCountByType("AEntity") - world.DeadObjects["AEntity"].size();
+    AMemoryUsage memory = GetMemoryUsage();
+
+    return {
+        {"entities", entityCount},
+        {"alive_entities", alive},
+        {"churn_per_frame", bench.ChurnPerFrame},
+        {"setup_ms", std::chrono::duration<double, std::milli>(setupEnd - setupStart).count()},
+        {"frame_ms", SummarizeMs(frameMs)},
+        {"systems", systemsJson},
+        {"memory", {{"rss_bytes", memory.Rss}, {"peak_rss_bytes", memory.PeakRss}, {"pool_bytes", poolBytes}, {"tags", tagsJson}, {"pools", poolsJson}}},
+        {"allocations", {{"count", allocationCount}, {"bytes", allocationBytes}, {"per_frame", (double)allocationCount / std::max(1, options.Frames)}}}};
+}
+
+// compares the average frame time of every entity count against a previous run
+static bool CheckBaseline(const ABenchOptions &options, const nlohmann::json &results)
+{
+    std::ifstream file(options.BaselinePath);
+    if (!file.is_open())
+    {
+        std::cout << "CheckBaseline | Error: Can't open baseline " << options.BaselinePath << std::endl;
+        return false;
+    }
+
+    nlohmann::json baseline = nlohmann::json::parse(file, nullptr, false);
+    if (baseline.is_discarded() || !baseline.contains("runs"))
+    {
+        std::cout << "CheckBaseline | Error: Invalid baseline " << options.BaselinePath << std::endl;
+        return false;
+    }
+
+    bool passed = true;
+    for (const nlohmann::json &run : results["runs"])
+    {
+        for (const nlohmann::json &baseRun : baseline["runs"])
+        {
+            if (baseRun["entities"] != run["entities"])
+            {
+                continue;
+            }
+
+            double current = run["frame_ms"]["avg"].get<double>();
+            double previous = baseRun["frame_ms"]["avg"].get<double>();
+            bool regressed = current > previous * (1.0 + options.Tolerance);
+
+            std::cout << fmt::format("{:>8} entities: {:.3f}ms vs {:.3f}ms baseline ({:+.1f}%){}",
+                                     run["entities"].get<size_t>(), current, previous,
+                                     (current / previous - 1.0) * 100.0, regressed ? " REGRESSION" : "")
+                      << std::endl;
+
+            passed = passed && !regressed;
+        }
+    }
+
+    return passed;
+}
+
+static std::vector<size_t> ParseCounts(const std::string &str)
+{
+    std::vector<size_t> counts;
+    std::stringstream stream(str);
+    std::string item;
+
+    while (std::getline(stream, item, ','))
+    {
+        counts.push_back(std::stoull(item));
+    }
+
+    return counts;
+}
+
+static bool ParseCommandLine(int argc, char **argv, ABenchOptions &options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (arg == "--entities" && hasValue)
+        {
+            options.EntityCounts = ParseCounts(argv[++i]);
+        }
+        else if (arg == "--frames" && hasValue)
+        {
+            options.Frames = std::stoi(argv[++i]);
+        }
+        else if (arg == "--warmup" && hasValue)
+        {
+            options.WarmupFrames = std::stoi(argv[++i]);
+        }
+        else if (arg == "--seed" && hasValue)
+        {
+            options.Seed = std::stoul(argv[++i]);
+        }
+        else if (arg == "--churn" && hasValue)
+        {
+            options.Churn = std::stof(argv[++i]);
+        }
+        else if (arg == "--dt" && hasValue)
+        {
+            options.DeltaTime = std::stof(argv[++i]);
+        }
+        else if (arg == "--threads" && hasValue)
+        {
+            options.Threads = std::stoi(argv[++i]);
+        }
+        else if (arg == "--out" && hasValue)
+        {
+            options.OutPath = argv[++i];
+        }
+        else if (arg == "--baseline" && hasValue)
+        {
+            options.BaselinePath = argv[++i];
+        }
+        else if (arg == "--tolerance" && hasValue)
+        {
+            options.Tolerance = std::stof(argv[++i]);
+        }
+        else if (arg == "--trace" && hasValue)
+        {
+            options.TracePath = argv[++i];
+        }
+        else
+        {
+            std::cout << "usage: AtlantisBench [--entities 1000,10000] [--frames N] [--warmup N] [--seed N] [--churn fraction]" << std::endl;
+            std::cout << "                     [--dt seconds] [--threads N] [--out file|-] [--baseline file] [--tolerance fraction] [--trace file]" << std::endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    ABenchOptions options;
+    if (!ParseCommandLine(argc, argv, options))
+    {
+        return 2;
+    }
+
+    if (options.Threads > 0)
+    {
+        omp_set_num_threads(options.Threads);
+    }
+
+    AProfiler::SetThreadName("Main");
+
+    if (!options.TracePath.empty())
+    {
+        AProfiler::BeginCapture(options.TracePath);
+    }
+
+    nlohmann::json results = {
+        {"version", 1},
+        {"frames", options.Frames},
+        {"warmup_frames", options.WarmupFrames},
+        {"seed", options.Seed},
+        {"churn", options.Churn},
+        {"delta_time", options.DeltaTime},
+        {"threads", omp_get_max_threads()},
+        {"runs", nlohmann::json::array()}};
+
+    for (size_t entityCount : options.EntityCounts)
+    {
+        nlohmann::json run = RunBench(options, entityCount);
+
+        std::cout << fmt::format("{:>8} entities: avg {:.3f}ms p99 {:.3f}ms, {:.1f} allocs/frame",
+                                 entityCount, run["frame_ms"]["avg"].get<double>(), run["frame_ms"]["p99"].get<double>(),
+                                 run["allocations"]["per_frame"].get<double>())
+                  << std::endl;
+
+        results["runs"].push_back(run);
+    }
+
+    // the last frame's events are still buffered, frames only collect the ones before them
+    AProfiler::Collect();
+    AProfiler::EndCapture();
+
+    if (options.OutPath == "-")
+    {
+        std::cout << results.dump(2) << std::endl;
+    }
+    else
+    {
+        std::ofstream out(options.OutPath);
+        out << results.dump(2) << std::endl;
+    }
+
+    if (!options.BaselinePath.empty() && !CheckBaseline(options, results))
+    {
+        return 1;
+    }
+
+    return 0;
+}
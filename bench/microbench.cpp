@@ -0,0 +1,276 @@
+// AtlantisMicroBench, google benchmark suite for the ECS primitives
+//
+// ./AtlantisMicroBench --benchmark_out=micro.json --benchmark_out_format=json
+// compare two runs with tools/compare.py from the google benchmark repo
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "engine/core.h"
+#include "engine/renderer/renderer.h"
+
+using namespace Atlantis;
+
+static void RegisterTypes(AWorld &world, size_t capacity)
+{
+    world.RegisterDefault<AEntity>(capacity, capacity);
+    world.RegisterDefault<CPosition>(capacity, capacity);
+    world.RegisterDefault<CColor>(capacity, capacity);
+    world.RegisterDefault<CVelocity>(capacity, capacity);
+    world.RegisterDefault<CRenderable>(capacity, capacity);
+    world.RegisterDefault<CCamera>(16, 16);
+}
+
+static AEntity *NewBunny(AWorld &world, size_t index)
+{
+    AEntity *e = world.NewObject_Internal<AEntity>();
+
+    CPosition *p = world.NewObject_Internal<CPosition>();
+    p->x = (float)(index % 800);
+    p->y = (float)(index % 450);
+
+    CVelocity *v = world.NewObject_Internal<CVelocity>();
+    v->x = 1.0f;
+    v->y = -1.0f;
+
+    e->AddComponent(p);
+    e->AddComponent(v);
+
+    // every other entity gets a color, so queries have something to filter
+    if (index % 2 == 0)
+    {
+        e->AddComponent(world.NewObject_Internal<CColor>());
+    }
+
+    return e;
+}
+
+// read-only benchmarks share one world per entity count, they stay alive until exit
+// so the static caches in the AWorld templates never point into a freed world
+static AWorld &GetSharedWorld(size_t count)
+{
+    static std::map<size_t, std::unique_ptr<AWorld>> worlds;
+
+    std::unique_ptr<AWorld> &world = worlds[count];
+    if (world == nullptr)
+    {
+        world = std::make_unique<AWorld>();
+        RegisterTypes(*world, count);
+
+        for (size_t i = 0; i < count; i++)
+        {
+            NewBunny(*world, i);
+        }
+    }
+
+    return *world;
+}
+
+static void BM_NewObject_Base(benchmark::State &state)
+{
+    size_t count = state.range(0);
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        auto world = std::make_unique<AWorld>();
+        RegisterTypes(*world, count);
+        state.ResumeTiming();
+
+        for (size_t i = 0; i < count; i++)
+        {
+            benchmark::DoNotOptimize(world->NewObject_Base<AEntity>("AEntity"));
+        }
+
+        state.PauseTiming();
+        world.reset();
+        state.ResumeTiming();
+    }
+
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_NewObject_Base)->RangeMultiplier(10)->Range(1000, 100000)->Unit(benchmark::kMicrosecond);
+
+static void BM_AddComponent(benchmark::State &state)
+{
+    size_t count = state.range(0);
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        auto world = std::make_unique<AWorld>();
+        RegisterTypes(*world, count);
+
+        std::vector<AEntity *> entities;
+        std::vector<AComponent *> components;
+        for (size_t i = 0; i < count; i++)
+        {
+            entities.push_back(world->NewObject_Internal<AEntity>());
+            components.push_back(world->NewObject_Internal<CPosition>());
+        }
+        state.ResumeTiming();
+
+        for (size_t i = 0; i < count; i++)
+        {
+            entities[i]->AddComponent(components[i]);
+        }
+
+        state.PauseTiming();
+        world.reset();
+        state.ResumeTiming();
+    }
+
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_AddComponent)->RangeMultiplier(10)->Range(1000, 100000)->Unit(benchmark::kMicrosecond);
+
+static void BM_GetComponentOfType(benchmark::State &state)
+{
+    AWorld &world = GetSharedWorld(state.range(0));
+    const auto &entities = world.GetObjectsByName("AEntity");
+
+    for (auto _ : state)
+    {
+        for (const auto &obj : entities)
+        {
+            benchmark::DoNotOptimize(static_cast<AEntity *>(obj.get())->GetComponentOfType<CVelocity>());
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * entities.size());
+}
+BENCHMARK(BM_GetComponentOfType)->RangeMultiplier(10)->Range(1000, 1000000)->Unit(benchmark::kMicrosecond);
+
+// uncached query, walks every entity and checks the mask
+static void BM_GetEntitiesWithComponents_Mask(benchmark::State &state)
+{
+    AWorld &world = GetSharedWorld(state.range(0));
+    ComponentBitset mask = world.GetComponentMaskForComponents({"CPosition", "CColor"});
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(world.GetEntitiesWithComponents(mask));
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_GetEntitiesWithComponents_Mask)->RangeMultiplier(10)->Range(1000, 1000000)->Unit(benchmark::kMicrosecond);
+
+// cached on the registry version, this is the path systems hit every frame
+static void BM_GetEntitiesWithComponents_Cached(benchmark::State &state)
+{
+    AWorld &world = GetSharedWorld(state.range(0));
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(world.GetEntitiesWithComponents<CPosition, CColor>().size());
+    }
+}
+BENCHMARK(BM_GetEntitiesWithComponents_Cached)->RangeMultiplier(10)->Range(1000, 1000000);
+
+// CVelocity doesn't block the render thread, so the lambda runs right away
+// instead of being queued for SyncEntities
+static void BM_ForEntitiesWithComponents(benchmark::State &state)
+{
+    AWorld &world = GetSharedWorld(state.range(0));
+    bool parallel = state.range(1) != 0;
+
+    for (auto _ : state)
+    {
+        world.ForEntitiesWithComponents(
+            [](AEntity *e, CVelocity *vel)
+            {
+                vel->x = -vel->x;
+            },
+            parallel);
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ForEntitiesWithComponents)
+    ->ArgsProduct({benchmark::CreateRange(1000, 1000000, 10), {0, 1}})
+    ->ArgNames({"entities", "parallel"})
+    ->Unit(benchmark::kMicrosecond)
+    ->UseRealTime();
+
+static void BM_AObjPtr_Get(benchmark::State &state)
+{
+    AWorld &world = GetSharedWorld(state.range(0));
+    const auto &positions = world.GetObjectsByName("CPosition");
+
+    std::vector<AObjPtr<CPosition>> ptrs;
+    ptrs.reserve(positions.size());
+    for (const auto &obj : positions)
+    {
+        ptrs.push_back(AObjPtr<CPosition>(static_cast<CPosition *>(obj.get())));
+    }
+
+    for (auto _ : state)
+    {
+        for (const AObjPtr<CPosition> &ptr : ptrs)
+        {
+            benchmark::DoNotOptimize(ptr.Get());
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * ptrs.size());
+}
+BENCHMARK(BM_AObjPtr_Get)->RangeMultiplier(10)->Range(1000, 100000)->Unit(benchmark::kMicrosecond);
+
+static void BM_AName_Construct(benchmark::State &state)
+{
+    std::string str(state.range(0), 'a');
+
+    for (auto _ : state)
+    {
+        AName name = str;
+        benchmark::DoNotOptimize(name);
+    }
+}
+BENCHMARK(BM_AName_Construct)->Arg(8)->Arg(32)->Arg(128);
+
+static void BM_AName_Compare(benchmark::State &state)
+{
+    std::string str(state.range(0), 'a');
+    AName l = str;
+    AName r = str;
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(l == r);
+    }
+}
+BENCHMARK(BM_AName_Compare)->Arg(8)->Arg(32)->Arg(128);
+
+// drains a modify queue of the given size, like queued systems do every frame
+static void BM_SyncEntities(benchmark::State &state)
+{
+    size_t count = state.range(0);
+    AWorld &world = GetSharedWorld(1000);
+    CPosition *pos = static_cast<CPosition *>(world.GetObjectsByName("CPosition")[0].get());
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        for (size_t i = 0; i < count; i++)
+        {
+            world.QueueSystem([pos]()
+                              { pos->x += 1.0f; });
+        }
+        state.ResumeTiming();
+
+        world.SyncEntities();
+
+        // there is no render thread to hand over to
+        world.RenderThreadProcessing = false;
+    }
+
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_SyncEntities)->RangeMultiplier(10)->Range(10, 100000)->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
@@ -23,6 +23,114 @@ current_file = None
 
 current_string = ""
 
+# property type spelling -> Atlantis::EPropertyKind, properties of other types
+# are still reflected, but not serialized
+property_kinds = {
+    "bool": "Bool",
+    "int": "Int",
+    "float": "Float",
+    "double": "Double",
+    "Color": "Color",
+    "Texture2D": "Texture2D",
+    "std::string": "String",
+    "Atlantis::AName": "Name",
+    "Atlantis::AResourceHandle": "ResourceHandle",
+}
+
+
+def generate_class(line, class_name, fields, bases=[]):
+    property_lines = []
+    serialize_lines = []
+    deserialize_lines = []
+    lua_lines = []
+
+    for index, field in enumerate(fields):
+        name = field["name"]
+        type_name = field["type"]
+        kind = property_kinds.get(type_name, "Unknown")
+
+        property_lines.append(f"""{{ "{name}", HashName("{name}"), "{type_name}", HashName("{type_name}"), offsetof({class_name}, {name}), sizeof({class_name}::{name}), EPropertyKind::{kind} }},""")
+
+        if kind != "Unknown":
+            serialize_lines.append(f"""properties.push_back(SerializePropertyJson("{name}", "{type_name}", offsetof({class_name}, {name}), {name}, cdo->{name}));""")
+            # handles are loaded by AObject::Deserialize, it has the world to resolve the path
+            if kind != "ResourceHandle":
+                deserialize_lines.append(f"""case {index}: value.get_to({name}); break;""")
+            lua_lines.append(f"""type["{name}"] = &{class_name}::{name};""")
+
+    # direct field access, the index is the property's position in classData.Properties
+    if serialize_lines:
+        serialize_lines.insert(0, f"""const {class_name} *cdo = static_cast<const {class_name} *>(cdoObject);""")
+    if deserialize_lines:
+        deserialize_lines = ["switch (index)", "{"] + deserialize_lines + ["default: break;", "}"]
+
+    # sol2 needs every base to pass the usertype where a base pointer is expected
+    lua_bases = f", sol::base_classes, sol::bases<{', '.join(bases)}>()" if bases else ""
+
+    # only keep the usertype around when there are members to add to it
+    new_usertype = f"""lua.new_usertype<{class_name}>("{class_name}", sol::no_constructor{lua_bases});"""
+    if lua_lines:
+        lua_lines.insert(0, f"""sol::usertype<{class_name}> type = {new_usertype}""")
+    else:
+        lua_lines.append(new_usertype)
+
+    # the table is constexpr so it ends up in read only data, a class without
+    # properties can't have an empty array
+    # the class data is built from it when the lib is loaded, as a static member so
+    # GetClassData doesn't pay for a function local static's guard on every call
+    if property_lines:
+        property_table = [f"static constexpr APropertyInfo properties[] = {{"] + property_lines + ["};", "return properties;"]
+    else:
+        property_table = ["return {};"]
+
+    return """#define __DEF_CLASS_HELPER_L_{line}() \\
+    static std::span<const APropertyInfo> GetPropertyTable() \\
+    {{ \\
+        {property_table} \\
+    }} \\
+    \\
+    static AClassData BuildClassData() \\
+    {{ \\
+        return AClassData::FromTable("{class_name}", sizeof({class_name}), GetPropertyTable(), &RegisterLuaType, &PushLua); \\
+    }} \\
+    \\
+    static inline const AClassData _classData = BuildClassData(); \\
+    \\
+    static const AClassData& GetClassDataStatic() \\
+    {{ \\
+        return _classData; \\
+    }} \\
+    \\
+    virtual const AClassData& GetClassData() const override \\
+    {{ \\
+        return _classData; \\
+    }} \\
+    \\
+    virtual void SerializeProperties(nlohmann::json &properties, const AObject *cdoObject) const override \\
+    {{ \\
+        {serialize} \\
+    }} \\
+    \\
+    virtual void DeserializeProperty(size_t index, const nlohmann::json &value) override \\
+    {{ \\
+        {deserialize} \\
+    }} \\
+    \\
+    static void RegisterLuaType(lua_State *L) \\
+    {{ \\
+        sol::state_view lua(L); \\
+        {lua} \\
+    }} \\
+    \\
+    static int PushLua(lua_State *L, AObject *object) \\
+    {{ \\
+        return sol::stack::push(L, static_cast<{class_name} *>(object)); \\
+    }}\n""".format(line=line, class_name=class_name,
+                   property_table=" \\\n\t\t".join(property_table),
+                   serialize=" \\\n\t\t".join(serialize_lines),
+                   deserialize=" \\\n\t\t".join(deserialize_lines),
+                   lua=" \\\n\t\t".join(lua_lines))
+
 
 def traverse_class_fields(node):
     if node.kind in [clang.cindex.CursorKind.FIELD_DECL, clang.cindex.CursorKind.CXX_METHOD]:
@@ -30,6 +138,16 @@ def traverse_class_fields(node):
     return ""
 
 
+def get_base_classes(node):
+    # closest first, including the bases' bases
+    bases = []
+    for c in node.get_children():
+        if c.kind == clang.cindex.CursorKind.CXX_BASE_SPECIFIER:
+            bases.append(c.type.spelling)
+            bases += get_base_classes(c.type.get_declaration())
+    return bases
+
+
 def class_decl(node):
     #print("    class", node.spelling)
     global current_class_name
@@ -53,34 +171,7 @@ def class_decl(node):
             if res:
                 fields_data.append(res)
         # print(fields_data)
-        current_string += """#define __DEF_CLASS_HELPER_L_{line}() \\
-    static AClassData& GetClassDataStatic() \\
-    {{ \\
-        static AClassData classData; \\
-        static bool initialized = false; \\
-        if (initialized) return classData; \\
-        initialized = true; \\
-            \\
-        classData.Name = "{class_name}"; \\
-        classData.Size = sizeof({class_name}); \\
-            \\
-        {fields} \\
-        return classData; \\
-    }} \\
-    \\
-    virtual const AClassData& GetClassData() const override \\
-    {{ \\
-        static AClassData classData; \\
-        static bool initialized = false; \\
-        if (initialized) return classData; \\
-        initialized = true; \\
-            \\
-        classData.Name = "{class_name}"; \\
-        classData.Size = sizeof({class_name}); \\
-            \\
-        {fields} \\
-        return classData; \\
-    }}\n""".format(line=macro_line, class_name=node.spelling, fields=" \\\n\t\t".join(fields_data))
+        current_string += generate_class(macro_line, node.spelling, fields_data, get_base_classes(node))
     pass
 
 
@@ -95,8 +186,7 @@ def field_decl(node):
         if node.location.line == current_macros[0]["line"] + 1:
             current_macros.pop(0)
 
-            # return f"""PropertyData propData {{ "{node.spelling}", "{node.type.spelling}", offsetof({current_class_name}, {node.spelling}) }};"""
-            return f"""classData.Properties.push_back({{ AName("{node.spelling}"), AName("{node.type.spelling}"), offsetof({current_class_name}, {node.spelling}) }});"""
+            return {"name": node.spelling, "type": node.type.spelling}
     return ""
 
 
@@ -59,29 +59,7 @@ function SomeSystem(world)
     --     end
     -- end
 
-    ForEntitiesWithComponents(name_components, function(entity)
-        local position = entity:GetComponentOfType(name_pos)
-        local velocity = entity:GetComponentOfType(name_vel)
-        position.x = position.x + velocity.x * dt
-        position.y = position.y + velocity.y * dt
-
-        if position.x < 0.0 then
-            position.x = 0.0
-            velocity.x = -velocity.x
-        end
-        if position.x > 800.0 then
-            position.x = 800.0
-            velocity.x = -velocity.x
-        end
-        if position.y < 0.0 then
-            position.y = 0.0
-            velocity.y = -velocity.y
-        end
-        if position.y > 450.0 then
-            position.y = 450.0
-            velocity.y = -velocity.y
-        end
-    end)
+    -- moving the bunnies runs on the worker states, see movement.lua
 
     if dt < 1.0 / 60.0 then
         for i = 1, 100 do
@@ -93,6 +71,10 @@ end
 function Init()
     print("Init")
     createBunny()
+end
 
+-- runs again whenever a script gets reloaded, systems are matched by their labels
+function RegisterSystems()
     RegisterSystem(SomeSystem, { AName.new("System") }, { AName.new("BeginRender") })
+    RegisterParallelSystem("movement", "Move", name_components, { AName.new("Movement") }, { AName.new("BeginRender") })
 end
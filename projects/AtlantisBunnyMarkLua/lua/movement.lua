@@ -0,0 +1,34 @@
+-- runs on the worker states through RegisterParallelSystem, so there's no world api
+-- here, only the chunk's component views and its command buffer
+local movement = {}
+
+function movement.Move(chunk, commands)
+    local positions, velocities = chunk.CPosition, chunk.CVelocity
+    local dt = chunk.dt
+
+    for i = 0, chunk.count - 1 do
+        local position = positions[i]
+        local velocity = velocities[i]
+        position.x = position.x + velocity.x * dt
+        position.y = position.y + velocity.y * dt
+
+        if position.x < 0.0 then
+            position.x = 0.0
+            velocity.x = -velocity.x
+        end
+        if position.x > 800.0 then
+            position.x = 800.0
+            velocity.x = -velocity.x
+        end
+        if position.y < 0.0 then
+            position.y = 0.0
+            velocity.y = -velocity.y
+        end
+        if position.y > 450.0 then
+            position.y = 450.0
+            velocity.y = -velocity.y
+        end
+    end
+end
+
+return movement
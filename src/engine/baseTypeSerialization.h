@@ -9,6 +9,34 @@ using json = nlohmann::json;
 NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(Color, r, g, b, a);
 NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(Texture2D, id, width, height, mipmaps, format);
 
+namespace Atlantis
+{
+    template <typename T>
+    inline bool Helper_IsEqual(const T &l, const T &r)
+    {
+        return l == r;
+    }
+
+    template <>
+    inline bool Helper_IsEqual(const Color &l, const Color &r)
+    {
+        return l.r == r.r && l.g == r.g && l.b == r.b && l.a == r.a;
+    }
+
+    template <>
+    inline bool Helper_IsEqual(const Texture2D &l, const Texture2D &r)
+    {
+        return l.id == r.id;
+    }
+
+    // one entry of AObject::Serialize's "Properties" array, used by the generated serializers
+    template <typename T>
+    inline json SerializePropertyJson(const char *name, const char *type, size_t offset, const T &value, const T &defaultValue)
+    {
+        return {{"Name", name}, {"Type", type}, {"Offset", offset}, {"Value", value}, {"IsDefault", Helper_IsEqual(value, defaultValue)}};
+    }
+}
+
 // custom specialization
 /*NLOHMANN_JSON_NAMESPACE_BEGIN
 template <>
@@ -0,0 +1,200 @@
+#include "engine/compression.h"
+#include <cstring>
+#include <vector>
+
+namespace Atlantis
+{
+    namespace
+    {
+        constexpr size_t MinMatch = 4;
+        constexpr size_t MaxOffset = 65535;
+        constexpr int HashBits = 14;
+
+        // the last literals are never part of a match, keeps the match loop from reading past the end
+        constexpr size_t LastLiterals = 5;
+
+        uint32_t Read32(const uint8_t *ptr)
+        {
+            uint32_t value;
+            memcpy(&value, ptr, sizeof(value));
+            return value;
+        }
+
+        uint32_t Hash(uint32_t value)
+        {
+            return (value * 2654435761u) >> (32 - HashBits);
+        }
+
+        uint8_t *WriteLength(uint8_t *dst, size_t length)
+        {
+            while (length >= 255)
+            {
+                *dst++ = 255;
+                length -= 255;
+            }
+            *dst++ = (uint8_t)length;
+            return dst;
+        }
+
+        uint8_t *WriteSequence(uint8_t *dst, const uint8_t *literals, size_t literalLength, size_t offset, size_t matchLength)
+        {
+            uint8_t *token = dst++;
+            *token = (uint8_t)((literalLength >= 15 ? 15 : literalLength) << 4);
+
+            if (literalLength >= 15)
+            {
+                dst = WriteLength(dst, literalLength - 15);
+            }
+
+            memcpy(dst, literals, literalLength);
+            dst += literalLength;
+
+            if (matchLength == 0)
+            {
+                return dst;
+            }
+
+            *dst++ = (uint8_t)(offset & 0xff);
+            *dst++ = (uint8_t)(offset >> 8);
+
+            size_t length = matchLength - MinMatch;
+            *token |= (uint8_t)(length >= 15 ? 15 : length);
+
+            if (length >= 15)
+            {
+                dst = WriteLength(dst, length - 15);
+            }
+
+            return dst;
+        }
+
+        bool ReadLength(const uint8_t *&src, const uint8_t *srcEnd, size_t &length)
+        {
+            uint8_t value;
+            do
+            {
+                if (src >= srcEnd)
+                {
+                    return false;
+                }
+
+                value = *src++;
+                length += value;
+            } while (value == 255);
+
+            return true;
+        }
+    }
+
+    size_t ACompression::CompressBound(size_t size)
+    {
+        return size + size / 255 + 16;
+    }
+
+    size_t ACompression::Compress(const uint8_t *src, size_t srcSize, uint8_t *dst)
+    {
+        uint8_t *out = dst;
+
+        if (srcSize < MinMatch + LastLiterals)
+        {
+            return WriteSequence(out, src, srcSize, 0, 0) - dst;
+        }
+
+        // positions + 1, 0 means empty
+        std::vector<uint32_t> table(1 << HashBits, 0);
+
+        const uint8_t *anchor = src;
+        const uint8_t *matchLimit = src + srcSize - LastLiterals;
+        const uint8_t *ip = src;
+
+        while (ip + MinMatch <= matchLimit)
+        {
+            uint32_t sequence = Read32(ip);
+            uint32_t &slot = table[Hash(sequence)];
+            const uint8_t *candidate = slot != 0 ? src + slot - 1 : nullptr;
+            slot = (uint32_t)(ip - src) + 1;
+
+            if (candidate == nullptr || (size_t)(ip - candidate) > MaxOffset || Read32(candidate) != sequence)
+            {
+                ip++;
+                continue;
+            }
+
+            size_t matchLength = MinMatch;
+            while (ip + matchLength < matchLimit && candidate[matchLength] == ip[matchLength])
+            {
+                matchLength++;
+            }
+
+            out = WriteSequence(out, anchor, ip - anchor, ip - candidate, matchLength);
+
+            ip += matchLength;
+            anchor = ip;
+        }
+
+        return WriteSequence(out, anchor, src + srcSize - anchor, 0, 0) - dst;
+    }
+
+    bool ACompression::Decompress(const uint8_t *src, size_t srcSize, uint8_t *dst, size_t dstSize)
+    {
+        const uint8_t *srcEnd = src + srcSize;
+        uint8_t *op = dst;
+        uint8_t *dstEnd = dst + dstSize;
+
+        while (src < srcEnd)
+        {
+            uint8_t token = *src++;
+
+            size_t literalLength = token >> 4;
+            if (literalLength == 15 && !ReadLength(src, srcEnd, literalLength))
+            {
+                return false;
+            }
+
+            if (literalLength > (size_t)(srcEnd - src) || literalLength > (size_t)(dstEnd - op))
+            {
+                return false;
+            }
+
+            memcpy(op, src, literalLength);
+            op += literalLength;
+            src += literalLength;
+
+            // last sequence has no match
+            if (src == srcEnd)
+            {
+                break;
+            }
+
+            if (srcEnd - src < 2)
+            {
+                return false;
+            }
+
+            size_t offset = src[0] | (src[1] << 8);
+            src += 2;
+
+            size_t matchLength = token & 15;
+            if (matchLength == 15 && !ReadLength(src, srcEnd, matchLength))
+            {
+                return false;
+            }
+            matchLength += MinMatch;
+
+            if (offset == 0 || offset > (size_t)(op - dst) || matchLength > (size_t)(dstEnd - op))
+            {
+                return false;
+            }
+
+            // matches may overlap their own output, copy byte by byte
+            const uint8_t *match = op - offset;
+            for (size_t i = 0; i < matchLength; i++)
+            {
+                op[i] = match[i];
+            }
+            op += matchLength;
+        }
+
+        return op == dstEnd;
+    }
+}
@@ -0,0 +1,30 @@
+#ifndef ATLANTIS_ENGINE_COMPRESSION_H
+#define ATLANTIS_ENGINE_COMPRESSION_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Atlantis
+{
+    // small LZ77 block compressor using the LZ4 block layout
+    //
+    // a block is a list of sequences: token (literal length << 4 | match length - 4),
+    // extra literal length bytes, literals, 2 byte match offset, extra match length bytes
+    // lengths of 15 continue in 255 steps, the last sequence is literals only
+    //
+    // favours speed over ratio, meant for snapshots and saves that are mostly
+    // small repeating records
+    struct ACompression
+    {
+        // worst case size of Compress's output for size input bytes
+        static size_t CompressBound(size_t size);
+
+        // returns the compressed size, dst needs CompressBound(srcSize) bytes
+        static size_t Compress(const uint8_t *src, size_t srcSize, uint8_t *dst);
+
+        // dstSize has to be the exact uncompressed size, returns false on corrupt input
+        static bool Decompress(const uint8_t *src, size_t srcSize, uint8_t *dst, size_t dstSize);
+    };
+}
+
+#endif // ATLANTIS_ENGINE_COMPRESSION_H
@@ -1,41 +1,21 @@
 #include "core.h"
 #include "system.h"
+#include <chrono>
+#include <cstring>
 #include <vector>
 #include <iostream>
 
-#define SERIALIZE_PROP_HELPER(type)                            \
-    if (propData.Type == #type)                                \
-    {                                                          \
-        type prop = GetProperty<type>(propData.Name);          \
-        type defProp = cdo->GetProperty<type>(propData.Name);  \
-        propJson["Value"] = prop;                              \
-        propJson["IsDefault"] = Helper_IsEqual(prop, defProp); \
-    }
-
-#define DESERIALIZE_PROP_HELPER(type)                                            \
-    if (prop["Type"].get<std::string>() == #type)                                \
-    {                                                                            \
-        SetProperty(prop["Name"].get<std::string>(), prop["Value"].get<type>()); \
-    }
-
 namespace Atlantis
 {
-    template <typename T>
-    bool Helper_IsEqual(const T &l, const T &r)
-    {
-        return l == r;
-    }
+    // system being processed on the current thread, used for stats
+    thread_local ASystem *CurrentSystem = nullptr;
 
-    template <>
-    bool Helper_IsEqual(const Color &l, const Color &r)
+    // seconds on a monotonic clock, unlike raylib's GetTime this doesn't need a window
+    static double GetWorldTime()
     {
-        return l.r == r.r && l.g == r.g && l.b == r.b && l.a == r.a;
-    }
+        static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
 
-    template <>
-    bool Helper_IsEqual(const Texture2D &l, const Texture2D &r)
-    {
-        return l.id == r.id;
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
     }
 
     void AObject::MarkObjectDead()
@@ -46,52 +26,176 @@ namespace Atlantis
         }
     }
 
+    namespace
+    {
+        template <typename T>
+        void SerializePropertyAt(nlohmann::json &properties, const APropertyData &propData, const AObject *object, const AObject *cdo)
+        {
+            const T &value = *reinterpret_cast<const T *>((size_t)object + propData.Offset);
+            const T &defaultValue = *reinterpret_cast<const T *>((size_t)cdo + propData.Offset);
+
+            properties.push_back({{"Name", propData.Name.GetName()},
+                                  {"Type", propData.Type.GetName()},
+                                  {"Offset", propData.Offset},
+                                  {"Value", value},
+                                  {"IsDefault", Helper_IsEqual(value, defaultValue)}});
+        }
+
+        template <typename T>
+        void DeserializePropertyAt(const nlohmann::json &value, const APropertyData &propData, AObject *object)
+        {
+            value.get_to(*reinterpret_cast<T *>((size_t)object + propData.Offset));
+        }
+    }
+
     nlohmann::json AObject::Serialize()
     {
         nlohmann::json json;
         const auto &classData = GetClassData();
+        const AObject *cdo = World != nullptr ? World->GetCDO<AObject>(classData.Name) : nullptr;
 
         json["Name"] = classData.Name.GetName();
         json["Properties"] = nlohmann::json::array({});
-        for (const auto &propData : classData.Properties)
-        {
-            nlohmann::json propJson = {{"Name", propData.Name.GetName()}, {"Type", propData.Type.GetName()}, {"Offset", propData.Offset}};
-            const AObject *cdo = World->GetCDO<AObject>(classData.Name);
-
-            SERIALIZE_PROP_HELPER(bool);
-            SERIALIZE_PROP_HELPER(int);
-            SERIALIZE_PROP_HELPER(float);
-            SERIALIZE_PROP_HELPER(double);
-            SERIALIZE_PROP_HELPER(Color);
-            SERIALIZE_PROP_HELPER(Texture2D);
-            SERIALIZE_PROP_HELPER(std::string);
-            SERIALIZE_PROP_HELPER(Atlantis::AName);
-            SERIALIZE_PROP_HELPER(Atlantis::AResourceHandle);
-
-            json["Properties"].push_back(propJson);
-        }
+        SerializeProperties(json["Properties"], cdo != nullptr ? cdo : this);
 
         return json;
     }
 
     void AObject::Deserialize(const nlohmann::json &json)
     {
+        const AClassData &classData = GetClassData();
+
+        size_t position = 0;
         for (auto &prop : json["Properties"])
         {
+            size_t index = position++;
+
             if (prop["IsDefault"])
             {
                 continue;
             }
 
-            DESERIALIZE_PROP_HELPER(bool);
-            DESERIALIZE_PROP_HELPER(int);
-            DESERIALIZE_PROP_HELPER(float);
-            DESERIALIZE_PROP_HELPER(double);
-            DESERIALIZE_PROP_HELPER(Color);
-            DESERIALIZE_PROP_HELPER(Texture2D);
-            DESERIALIZE_PROP_HELPER(std::string);
-            DESERIALIZE_PROP_HELPER(Atlantis::AName);
-            DESERIALIZE_PROP_HELPER(Atlantis::AResourceHandle);
+            // properties are written in declaration order, only search when the layout changed
+            AName name = prop["Name"].get<std::string>();
+            if (index >= classData.Properties.size() || !(classData.Properties[index].Name == name))
+            {
+                int found = classData.FindPropertyIndex(name);
+                if (found < 0)
+                {
+                    continue;
+                }
+
+                index = (size_t)found;
+            }
+
+            if (!(classData.Properties[index].Type == prop["Type"].get<std::string>()))
+            {
+                continue;
+            }
+
+            // handles are stored by path and need the world's holder to load
+            if (classData.Properties[index].GetKind() == EPropertyKind::ResourceHandle)
+            {
+                DeserializeResourceHandle(index, prop["Value"]);
+                continue;
+            }
+
+            DeserializeProperty(index, prop["Value"]);
+        }
+    }
+
+    void AObject::DeserializeResourceHandle(size_t index, const nlohmann::json &value)
+    {
+        const APropertyData &propData = GetClassData().Properties[index];
+        AResourceHandle &handle = *reinterpret_cast<AResourceHandle *>((size_t)this + propData.Offset);
+        std::string path = value.is_string() ? value.get<std::string>() : std::string();
+
+        if (path.empty())
+        {
+            handle = AResourceHandle();
+            return;
+        }
+
+        if (World == nullptr)
+        {
+            std::cout << "AObject::DeserializeResourceHandle | Error: No world to load " << path << " for " << propData.Name.GetName() << std::endl;
+            return;
+        }
+
+        handle = World->ResourceHolder.GetTexture(path);
+    }
+
+    void AObject::SerializeProperties(nlohmann::json &properties, const AObject *cdoObject) const
+    {
+        for (const APropertyData &propData : GetClassData().Properties)
+        {
+            switch (propData.GetKind())
+            {
+            case EPropertyKind::Bool:
+                SerializePropertyAt<bool>(properties, propData, this, cdoObject);
+                break;
+            case EPropertyKind::Int:
+                SerializePropertyAt<int>(properties, propData, this, cdoObject);
+                break;
+            case EPropertyKind::Float:
+                SerializePropertyAt<float>(properties, propData, this, cdoObject);
+                break;
+            case EPropertyKind::Double:
+                SerializePropertyAt<double>(properties, propData, this, cdoObject);
+                break;
+            case EPropertyKind::Color:
+                SerializePropertyAt<Color>(properties, propData, this, cdoObject);
+                break;
+            case EPropertyKind::Texture2D:
+                SerializePropertyAt<Texture2D>(properties, propData, this, cdoObject);
+                break;
+            case EPropertyKind::String:
+                SerializePropertyAt<std::string>(properties, propData, this, cdoObject);
+                break;
+            case EPropertyKind::Name:
+                SerializePropertyAt<AName>(properties, propData, this, cdoObject);
+                break;
+            case EPropertyKind::ResourceHandle:
+                SerializePropertyAt<AResourceHandle>(properties, propData, this, cdoObject);
+                break;
+            default:
+                break;
+            }
+        }
+    }
+
+    void AObject::DeserializeProperty(size_t index, const nlohmann::json &value)
+    {
+        const APropertyData &propData = GetClassData().Properties[index];
+
+        switch (propData.GetKind())
+        {
+        case EPropertyKind::Bool:
+            DeserializePropertyAt<bool>(value, propData, this);
+            break;
+        case EPropertyKind::Int:
+            DeserializePropertyAt<int>(value, propData, this);
+            break;
+        case EPropertyKind::Float:
+            DeserializePropertyAt<float>(value, propData, this);
+            break;
+        case EPropertyKind::Double:
+            DeserializePropertyAt<double>(value, propData, this);
+            break;
+        case EPropertyKind::Color:
+            DeserializePropertyAt<Color>(value, propData, this);
+            break;
+        case EPropertyKind::Texture2D:
+            DeserializePropertyAt<Texture2D>(value, propData, this);
+            break;
+        case EPropertyKind::String:
+            DeserializePropertyAt<std::string>(value, propData, this);
+            break;
+        case EPropertyKind::Name:
+            DeserializePropertyAt<AName>(value, propData, this);
+            break;
+        default:
+            break;
         }
     }
 
@@ -176,6 +280,11 @@ namespace Atlantis
         ObjectModifyQueue.push_back(lambda);
     }
 
+    void AWorld::QueueSyncPoint(std::function<void()> lambda)
+    {
+        SyncPointQueue.push_back(lambda);
+    }
+
     void Atlantis::AWorld::QueueModifyObject(
         AObjPtr<AObject> object,
         std::function<void(AObject*)> lambda)
@@ -191,11 +300,47 @@ namespace Atlantis
 
     void AWorld::MarkObjectDead(AObject *object)
     {
+        const AClassData &classData = object->GetClassData();
+
         object->_isAlive = false;
-        DeadObjects[object->GetClassData().Name].push_back(object);
+        ReleaseResourceRefs(classData, object);
+        DeadObjects[classData.Name].push_back(object);
         _registryVersion++;
     }
 
+    void AWorld::AcquireResourceRefs(const AClassData &classData, void *object)
+    {
+        for (const APropertyData &propData : classData.Properties)
+        {
+            if (propData.GetKind() == EPropertyKind::ResourceHandle)
+            {
+                reinterpret_cast<const AResourceHandle *>((size_t)object + propData.Offset)->AcquireCopiedRef();
+            }
+        }
+    }
+
+    void AWorld::ReleaseResourceRefs(const AClassData &classData, void *object)
+    {
+        for (const APropertyData &propData : classData.Properties)
+        {
+            if (propData.GetKind() == EPropertyKind::ResourceHandle)
+            {
+                reinterpret_cast<AResourceHandle *>((size_t)object + propData.Offset)->Reset();
+            }
+        }
+    }
+
+    void AWorld::CopyResourceRefs(const AClassData &classData, void *object, const void *cdo)
+    {
+        for (const APropertyData &propData : classData.Properties)
+        {
+            if (propData.GetKind() == EPropertyKind::ResourceHandle)
+            {
+                *reinterpret_cast<AResourceHandle *>((size_t)object + propData.Offset) = *reinterpret_cast<const AResourceHandle *>((size_t)cdo + propData.Offset);
+            }
+        }
+    }
+
     void AWorld::QueueObjectDeletion(AObjPtr<AObject> object)
     {
         ObjectDestroyQueue.push_back(object);
@@ -206,6 +351,16 @@ namespace Atlantis
         return _deltaTime;
     }
 
+    void AWorld::SetFixedDeltaTime(float deltaTime)
+    {
+        _fixedDeltaTime = deltaTime;
+    }
+
+    uint AWorld::GetFrame() const
+    {
+        return _frame;
+    }
+
     bool AWorld::IsMainThread() const
     {
         return std::this_thread::get_id() == MAIN_THREAD_ID;
@@ -220,6 +375,9 @@ namespace Atlantis
     {
         std::unique_ptr<ASystem> systemPtr(system);
 
+        system->BuildName();
+        system->ProfileZone = AProfiler::GetNamedZone(system->GetName());
+
         if (system->IsRenderSystem)
         {
             if (beforeLabels.size() > 0)
@@ -296,19 +454,48 @@ namespace Atlantis
 
     void AWorld::ProcessSystems()
     {
+        AProfiler::MarkFrame();
+        AProfiler::Collect();
+
+        AMemoryTracker::MarkFrame();
+        UpdateMemoryStats();
+
         _frame++;
-        _currentFrameTime = GetTime();
+        _currentFrameTime = GetWorldTime();
 
-        if (_lastFrameTime > 0.0f)
+        if (_fixedDeltaTime > 0.0f)
+        {
+            _deltaTime = _fixedDeltaTime;
+        }
+        else if (_lastFrameTime > 0.0f)
         {
             _deltaTime = _currentFrameTime - _lastFrameTime;
         }
 
+        if (AProfiler::IsCapturing())
+        {
+            AProfiler::SetCounter("Entities", GetObjectCountByType("AEntity") - DeadObjects["AEntity"].size());
+            AProfiler::SetCounter("ObjectCreateQueue", ObjectCreateCommandsQueue.size());
+            AProfiler::SetCounter("ObjectModifyQueue", ObjectModifyQueue.size());
+            AProfiler::SetCounter("ObjectDestroyQueue", ObjectDestroyQueue.size());
+
+            AResourceStats resourceStats = ResourceHolder.GetStats();
+            AProfiler::SetCounter("ResidentTextureBytes", resourceStats.ResidentBytes);
+            AProfiler::SetCounter("TextureEvictions", resourceStats.Evictions);
+            AProfiler::SetCounter("TextureReloads", resourceStats.Reloads);
+
+            for (size_t i = 0; i < (size_t)EMemoryTag::Count; i++)
+            {
+                EMemoryTag tag = (EMemoryTag)i;
+                AProfiler::SetCounter(std::string("Memory") + AMemoryTracker::GetTagName(tag), AMemoryTracker::GetStats(tag).LiveBytes);
+            }
+        }
+
         SyncEntities();
 
         for (std::unique_ptr<ASystem> &system : Systems)
         {
-            system->Process(this);
+            ProcessSystem(system.get());
         }
 
         _lastFrameTime = _currentFrameTime;
@@ -316,6 +503,8 @@ namespace Atlantis
 
     void AWorld::ProcessSystemsRenderThread()
     {
+        AProfiler::MarkFrame();
+
         while (MainThreadProcessing)
         {
             std::this_thread::sleep_for(std::chrono::microseconds(1));
@@ -331,9 +520,11 @@ namespace Atlantis
 
         RenderThreadCallQueue.clear();
 
+        ResourceHolder.Update();
+
         for (std::unique_ptr<ASystem> &system : SystemsRenderThread)
         {
-            system->Process(this);
+            ProcessSystem(system.get());
         }
 
         RenderThreadProcessing = false;
@@ -341,6 +532,94 @@ namespace Atlantis
         RenderThreadMutex.unlock();
     }
 
+    void AWorld::ProcessSystem(ASystem *system)
+    {
+        ASystem *previousSystem = CurrentSystem;
+        CurrentSystem = system;
+        system->Stats.EntitiesProcessed = 0;
+
+        auto start = std::chrono::steady_clock::now();
+        {
+            AProfileScope profileScope(system->ProfileZone);
+            system->Process(this);
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        system->Stats.AddSample(std::chrono::duration<float, std::milli>(end - start).count());
+        CurrentSystem = previousSystem;
+    }
+
+    std::vector<AWorld::ASystemStatsEntry> AWorld::GetSystemStats()
+    {
+        std::vector<ASystemStatsEntry> stats;
+        stats.reserve(Systems.size() + SystemsRenderThread.size() + 1);
+
+        stats.push_back({"SyncEntities", false, false, SyncStats});
+
+        // NOTE: stats of the other thread's systems may be mid-update, fine for display
+        for (auto *systems : {&Systems, &SystemsRenderThread})
+        {
+            for (std::unique_ptr<ASystem> &system : *systems)
+            {
+                stats.push_back({system->GetName(), system->IsRenderSystem, system->IsTimesliced, system->Stats});
+            }
+        }
+
+        return stats;
+    }
+
+    std::vector<APoolStats> AWorld::GetPoolStats() const
+    {
+        std::vector<APoolStats> pools;
+        FillPoolStats(pools);
+
+        return pools;
+    }
+
+    // reuses the entries already in pools, the snapshot is refilled every frame
+    void AWorld::FillPoolStats(std::vector<APoolStats> &pools) const
+    {
+        pools.resize(AllocatorHelpers.size());
+
+        size_t index = 0;
+        for (const auto &[name, helper] : AllocatorHelpers)
+        {
+            auto objects = ObjectLists.find(name);
+            auto dead = DeadObjects.find(name);
+            size_t listCapacity = objects != ObjectLists.end() ? objects->second.capacity() : 0;
+            size_t deadCapacity = dead != DeadObjects.end() ? dead->second.capacity() : 0;
+
+            APoolStats &pool = pools[index++];
+            pool.Name.assign(name.Name.data());
+            pool.ElementSize = helper.ElementSize;
+            pool.Capacity = helper.Limit;
+            pool.Used = helper.Count;
+            pool.Dead = dead != DeadObjects.end() ? dead->second.size() : 0;
+            pool.ReservedBytes = helper.Limit * helper.ElementSize;
+            pool.LiveBytes = (pool.Used - std::min(pool.Dead, pool.Used)) * helper.ElementSize;
+            pool.BookkeepingBytes = listCapacity * sizeof(std::unique_ptr<AObject, no_deleter>) +
+                                    deadCapacity * sizeof(AObjPtr<AObject>);
+            pool.Fragmentation = pool.Used > 0 ? (float)pool.Dead / (float)pool.Used : 0.0f;
+        }
+    }
+
+    void AWorld::UpdateMemoryStats()
+    {
+        size_t bookkeeping = 0;
+
+        for (const auto &[name, objects] : ObjectLists)
+        {
+            bookkeeping += objects.capacity() * sizeof(std::unique_ptr<AObject, no_deleter>);
+        }
+
+        for (const auto &[name, objects] : DeadObjects)
+        {
+            bookkeeping += objects.capacity() * sizeof(AObjPtr<AObject>);
+        }
+
+        AMemoryTracker::SetLiveBytes(EMemoryTag::ObjectLists, bookkeeping);
+    }
+
     void AWorld::QueueRenderThreadCall(std::function<void()> lambda)
     {
         RenderThreadMutex.lock();
@@ -350,6 +629,8 @@ namespace Atlantis
 
     void AWorld::SyncEntities()
     {
+        DO_PROFILE("SyncEntities", MAROON);
+
         while (RenderThreadProcessing)
         {
             std::this_thread::sleep_for(std::chrono::microseconds(1));
@@ -358,6 +639,8 @@ namespace Atlantis
         RenderThreadMutex.lock();
         MainThreadProcessing = true;
 
+        auto start = std::chrono::steady_clock::now();
+
         // Process object creation queue
         for (auto &command : ObjectCreateCommandsQueue)
         {
@@ -379,6 +662,20 @@ namespace Atlantis
             command();
         }
 
+        // sync point callbacks may queue the next one
+        std::vector<std::function<void()>> syncPointQueue;
+        syncPointQueue.swap(SyncPointQueue);
+        for (auto &command : syncPointQueue)
+        {
+            command();
+        }
+
+        auto end = std::chrono::steady_clock::now();
+        SyncStats.AddSample(std::chrono::duration<float, std::milli>(end - start).count());
+
+        // the render thread can't read the pools while the main thread's systems run
+        FillPoolStats(PoolStatsSnapshot);
+
         MainThreadProcessing = false;
         RenderThreadProcessing = true;
         RenderThreadMutex.unlock();
@@ -437,17 +734,22 @@ namespace Atlantis
             {
                 end = entities.size();
                 system->CurrentObjectIndex = 0;
+                system->Stats.TimesliceCycles++;
             }
             else
             {
                 system->CurrentObjectIndex = end;
             }
+
+            system->Stats.TimesliceProgress = entities.size() > 0 ? (float)end / entities.size() : 1.0f;
         }
 
+        size_t processed = 0;
+
         if (parallel)
         {
 // MSVC currently supports only OpenMP 2.0, which doesn't like range-based for loops :(
-#pragma omp parallel for
+#pragma omp parallel for reduction(+ : processed)
             for (int i = start; i < end; i++)
             {
                 AEntity *entity = static_cast<AEntity *>(entities[i].get());
@@ -455,6 +757,7 @@ namespace Atlantis
                 if (entity->_isAlive && entity->HasComponentsByMask(componentMask))
                 {
                     lambda(entity);
+                    processed++;
                 }
             }
         }
@@ -467,9 +770,16 @@ namespace Atlantis
                 if (entity->_isAlive && entity->HasComponentsByMask(componentMask))
                 {
                     lambda(entity);
+                    processed++;
                 }
             }
         }
+
+        ASystem *statsSystem = system != nullptr ? system : CurrentSystem;
+        if (statsSystem != nullptr)
+        {
+            statsSystem->Stats.EntitiesProcessed += processed;
+        }
     }
 
     ComponentBitset AWorld::GetComponentMaskForComponents(std::vector<AName> componentsNames)
@@ -490,8 +800,29 @@ namespace Atlantis
         return ret;
     }
 
+    namespace
+    {
+        // dead objects already gave theirs up, their handles are invalid
+        void ReleasePoolResourceRefs(const AClassData &classData, const AWorld::AllocatorMemoryHelper &helper)
+        {
+            for (size_t i = 0; i < helper.Count; i++)
+            {
+                AWorld::ReleaseResourceRefs(classData, (void *)(helper.Start + i * helper.ElementSize));
+            }
+        }
+    }
+
     void AWorld::Clear()
     {
+        for (const auto &[name, helper] : AllocatorHelpers)
+        {
+            auto it = CData.find(name);
+            if (it != CData.end())
+            {
+                ReleasePoolResourceRefs(*it->second, helper);
+            }
+        }
+
         CData.clear();
         CDOs.clear();
         ObjectLists.clear();
@@ -506,69 +837,486 @@ namespace Atlantis
         for (auto thing : AllocatorHelpers)
         {
             free((void *)thing.second.Start);
+            AMemoryTracker::Free(EMemoryTag::ObjectPools, thing.second.Limit * thing.second.ElementSize);
         }
 
         AllocatorHelpers.clear();
     }
 
-    void AWorld::OnPreHotReload()
+    namespace
     {
-        ObjectCreateCommandsQueue.clear();
-        ObjectDestroyQueue.clear();
-        ObjectModifyQueue.clear();
+        // layouts as far as reflection can tell, non property members aren't compared
+        bool IsSameLayout(const AClassData &oldData, const AClassData &newData)
+        {
+            if (oldData.Size != newData.Size || oldData.Properties.size() != newData.Properties.size())
+            {
+                return false;
+            }
+
+            for (size_t i = 0; i < newData.Properties.size(); i++)
+            {
+                const APropertyData &oldProp = oldData.Properties[i];
+                const APropertyData &newProp = newData.Properties[i];
+
+                if (!(oldProp.Name == newProp.Name) || !(oldProp.Type == newProp.Type) || oldProp.Offset != newProp.Offset || oldProp.Size != newProp.Size)
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        struct AMigratedProperty
+        {
+            EPropertyKind Kind = EPropertyKind::Unknown;
+            size_t Size = 0;
+            size_t OldOffset = 0;
+            size_t NewOffset = 0;
+        };
+
+        // dst holds a byte copy of the CDO's value, so it gets overwritten without
+        // destructing it, src is never destructed either, so it's moved out of
+        void MoveProperty(const AMigratedProperty &prop, void *dst, void *src)
+        {
+            switch (prop.Kind)
+            {
+            case EPropertyKind::String:
+                new (dst) std::string(std::move(*static_cast<std::string *>(src)));
+                break;
+            case EPropertyKind::Name:
+            {
+                AName *name = new (dst) AName();
+                name->Name = std::move(static_cast<AName *>(src)->Name);
+                name->Hash = static_cast<AName *>(src)->Hash;
+                break;
+            }
+            case EPropertyKind::Unknown:
+                break;
+            case EPropertyKind::ResourceHandle:
+                *static_cast<AResourceHandle *>(dst) = *static_cast<AResourceHandle *>(src);
+                static_cast<AResourceHandle *>(src)->Reset();
+                break;
+            default:
+                memcpy(dst, src, prop.Size);
+                break;
+            }
+        }
+
+        bool IsInPool(const AWorld::AllocatorMemoryHelper &helper, const void *object)
+        {
+            size_t address = (size_t)object;
+            return address >= helper.Start && address < helper.Start + helper.Count * helper.ElementSize;
+        }
     }
 
-    void AWorld::OnPostHotReload()
+    void AWorld::RegisterPool(const AName &name, const AClassData &data, std::unique_ptr<AObject> cdo, bool isComponent, size_t amount, size_t increment)
     {
-        // TODO: hack
-        _currentFrameTime = GetTime();
-        _deltaTime = 0.0001f;
-        _lastFrameTime = _currentFrameTime - _deltaTime;
-        _frame++;
+        CData.insert_or_assign(name, &data);
+
+        CDOs.insert_or_assign(name, std::move(cdo));
+
+        if (isComponent)
+        {
+            if (std::find(ComponentNames.begin(), ComponentNames.end(), name) == ComponentNames.end())
+            {
+                ComponentNames.push_back(name);
+            }
+        }
+
+        // the type had a pool before the hot reload, hold on to its objects
+        if (_hotReload != nullptr && _hotReload->AllocatorHelpers.contains(name))
+        {
+            if (IsSameLayout(_hotReload->CData.at(name), data))
+            {
+                KeepPool(name, increment);
+            }
+            else
+            {
+                MigratePool(name, amount, increment);
+            }
+
+            return;
+        }
+
+        size_t memBlock = (size_t)malloc(amount * data.Size);
+
+        AllocatorMemoryHelper allocatorHelper;
+        allocatorHelper.Start = memBlock;
+        allocatorHelper.Count = 0;
+        allocatorHelper.Limit = amount;
+        allocatorHelper.Increment = increment;
+        allocatorHelper.ElementSize = data.Size;
+
+        AMemoryTracker::Allocate(EMemoryTag::ObjectPools, amount * data.Size);
+
+        AllocatorHelpers.insert_or_assign(name, allocatorHelper);
+
+        ObjectLists[name].reserve(allocatorHelper.Limit);
+        DeadObjects[name].reserve(allocatorHelper.Limit);
     }
 
-    void AWorld::OnShutdown()
+    void AWorld::RegisterDynamic(const AClassData &data, std::unique_ptr<AObject> cdo, size_t amount, size_t increment)
     {
-        MainThreadProcessing = false;
-        RenderThreadProcessing = false;
+        bool isComponent = dynamic_cast<AComponent *>(cdo.get()) != nullptr;
+
+        RegisterPool(data.Name, data, std::move(cdo), isComponent, amount, increment);
     }
 
-    AResourceHandle AResourceHolder::GetTexture(std::string path)
+    void AWorld::BeginHotReload()
     {
-        if (World == nullptr)
+        if (_hotReload != nullptr)
         {
-            std::cout << "AResourceHolder::GetTexture | Error: World is null" << std::endl;
-            return AResourceHandle();
+            std::cout << "AWorld::BeginHotReload | Error: Hot reload already in progress" << std::endl;
+            return;
         }
 
-        if (Resources.contains(path))
+        _hotReload = std::make_unique<AHotReloadState>();
+        _hotReload->StartTime = GetWorldTime();
+
+        for (auto &[name, cdo] : CDOs)
         {
-            AResourceHandle ret(Resources.at(path).get());
-            return ret;
+            if (dynamic_cast<AEntity *>(cdo.get()) != nullptr)
+            {
+                _hotReload->EntityTypes.insert(name);
+            }
         }
 
-        if (World->IsMainThread())
+        for (auto &[name, helper] : AllocatorHelpers)
         {
-            World->QueueRenderThreadCall([this, path]()
-                                         { Resources.emplace(path, std::move(std::make_unique<ATextureResource>(LoadTexture((Helpers::GetProjectDirectory().string() + path).c_str())))); });
+            AMemoryTracker::Free(EMemoryTag::ObjectPools, helper.Limit * helper.ElementSize);
+            AMemoryTracker::Allocate(EMemoryTag::HotReload, helper.Limit * helper.ElementSize);
         }
-        else
+
+        for (const auto &[name, data] : CData)
         {
-            Resources.emplace(path, std::move(std::make_unique<ATextureResource>(LoadTexture((Helpers::GetProjectDirectory().string() + path).c_str()))));
+            _hotReload->CData.insert_or_assign(name, *data);
         }
 
-        AResourceHandle ret(this, path);
-        return ret;
+        _hotReload->AllocatorHelpers = std::move(AllocatorHelpers);
+        _hotReload->ObjectLists = std::move(ObjectLists);
+        _hotReload->DeadObjects = std::move(DeadObjects);
+        _hotReload->ComponentNames = std::move(ComponentNames);
+
+        CData.clear();
+        AllocatorHelpers.clear();
+        ObjectLists.clear();
+        DeadObjects.clear();
+        ComponentNames.clear();
+
+        // CDOs and systems live in the old lib's code, let go of them before it's unloaded
+        CDOs.clear();
+        Systems.clear();
+        SystemsRenderThread.clear();
     }
 
-    void *AResourceHolder::GetResourcePtr(std::string path)
+    void AWorld::KeepPool(const AName &name, size_t increment)
     {
-        if (Resources.contains(path))
+        AllocatorMemoryHelper helper = _hotReload->AllocatorHelpers.at(name);
+        helper.Increment = increment;
+
+        // the objects still point at the old lib's vtable, the vtable pointer is the
+        // first thing in the object with single inheritance
+        const AObject *cdo = CDOs.at(name).get();
+        if (helper.Count > 0 && memcmp((void *)helper.Start, (const void *)cdo, sizeof(void *)) != 0)
         {
-            return Resources.at(path).get();
+            for (size_t i = 0; i < helper.Count; i++)
+            {
+                memcpy((void *)(helper.Start + i * helper.ElementSize), (const void *)cdo, sizeof(void *));
+            }
         }
 
-        return nullptr;
+        AMemoryTracker::Free(EMemoryTag::HotReload, helper.Limit * helper.ElementSize);
+        AMemoryTracker::Allocate(EMemoryTag::ObjectPools, helper.Limit * helper.ElementSize);
+
+        AllocatorHelpers.insert_or_assign(name, helper);
+        ObjectLists[name] = std::move(_hotReload->ObjectLists[name]);
+        DeadObjects[name] = std::move(_hotReload->DeadObjects[name]);
+
+        _hotReload->CData.erase(name);
+        _hotReload->AllocatorHelpers.erase(name);
+        _hotReload->ObjectLists.erase(name);
+        _hotReload->DeadObjects.erase(name);
+        _hotReload->KeptPools++;
+    }
+
+    void AWorld::MigratePool(const AName &name, size_t amount, size_t increment)
+    {
+        const AClassData &oldData = _hotReload->CData.at(name);
+        const AClassData &newData = *CData.at(name);
+        const AObject *cdo = CDOs.at(name).get();
+
+        AllocatorMemoryHelper oldHelper = _hotReload->AllocatorHelpers.at(name);
+
+        AllocatorMemoryHelper helper;
+        helper.Limit = std::max(amount, oldHelper.Count);
+        helper.Count = oldHelper.Count;
+        helper.Increment = increment;
+        helper.ElementSize = newData.Size;
+        helper.Start = (size_t)malloc(helper.Limit * helper.ElementSize);
+
+        AMemoryTracker::Allocate(EMemoryTag::ObjectPools, helper.Limit * helper.ElementSize);
+
+        // properties are matched by name and type, same as restoring a snapshot
+        std::vector<AMigratedProperty> properties;
+        for (const APropertyData &newProp : newData.Properties)
+        {
+            const APropertyData *oldProp = oldData.FindProperty(newProp.Name);
+            if (oldProp != nullptr && oldProp->Type == newProp.Type && oldProp->Size == newProp.Size)
+            {
+                AMigratedProperty prop;
+                prop.Kind = newProp.GetKind();
+                prop.Size = newProp.Size;
+                prop.OldOffset = oldProp->Offset;
+                prop.NewOffset = newProp.Offset;
+                properties.push_back(prop);
+            }
+        }
+
+        bool isEntity = dynamic_cast<const AEntity *>(cdo) != nullptr;
+        bool isComponent = dynamic_cast<const AComponent *>(cdo) != nullptr;
+
+        auto &objects = ObjectLists[name];
+        objects.clear();
+        objects.reserve(helper.Limit);
+
+        for (size_t i = 0; i < helper.Count; i++)
+        {
+            // only plain members of the old objects are touched, their vtable is gone
+            AObject *oldObj = reinterpret_cast<AObject *>(oldHelper.Start + i * oldHelper.ElementSize);
+            void *slot = (void *)(helper.Start + i * helper.ElementSize);
+
+            memcpy(slot, (const void *)cdo, helper.ElementSize);
+
+            AObject *obj = static_cast<AObject *>(slot);
+            obj->World = this;
+            obj->_uid = oldObj->_uid;
+            obj->_isAlive = oldObj->_isAlive;
+
+            // the memcpy didn't take references for the CDO's handles, only live objects
+            // hold them, the old object's handles are moved over below
+            for (const APropertyData &propData : newData.Properties)
+            {
+                if (propData.GetKind() == EPropertyKind::ResourceHandle)
+                {
+                    new ((void *)((size_t)obj + propData.Offset)) AResourceHandle();
+                }
+            }
+
+            if (obj->_isAlive)
+            {
+                CopyResourceRefs(newData, obj, cdo);
+            }
+
+            if (isEntity)
+            {
+                AEntity *entity = static_cast<AEntity *>(obj);
+                AEntity *oldEntity = static_cast<AEntity *>(oldObj);
+
+                new (&entity->Components) std::vector<AComponent *>(std::move(oldEntity->Components));
+                new (&entity->ComponentNames) std::vector<AName>(std::move(oldEntity->ComponentNames));
+                entity->_componentMask = oldEntity->_componentMask;
+            }
+            else if (isComponent)
+            {
+                static_cast<AComponent *>(obj)->Owner = static_cast<AComponent *>(oldObj)->Owner;
+            }
+
+            for (const AMigratedProperty &prop : properties)
+            {
+                MoveProperty(prop, (void *)((size_t)obj + prop.NewOffset), (void *)((size_t)oldObj + prop.OldOffset));
+            }
+
+            // handles of properties that didn't survive the reload
+            ReleaseResourceRefs(oldData, oldObj);
+
+            std::unique_ptr<AObject, no_deleter> sPtr(obj);
+            objects.push_back(std::move(sPtr));
+        }
+
+        AllocatorHelpers.insert_or_assign(name, helper);
+        DeadObjects[name] = std::move(_hotReload->DeadObjects[name]);
+
+        AMigratedPool migrated;
+        migrated.Old = oldHelper;
+        migrated.NewStart = helper.Start;
+        migrated.NewElementSize = helper.ElementSize;
+        migrated.IsEntity = isEntity;
+        _hotReload->MigratedPools.push_back(migrated);
+        _hotReload->MigratedObjects += helper.Count;
+
+        std::cout << "Migrating " << helper.Count << " objects of type " << name.GetName() << " to a new layout" << std::endl;
+
+        // the old pool is freed in EndHotReload, references into it get fixed there
+        _hotReload->CData.erase(name);
+        _hotReload->AllocatorHelpers.erase(name);
+        _hotReload->ObjectLists.erase(name);
+        _hotReload->DeadObjects.erase(name);
+    }
+
+    AObject *AWorld::RemapMigratedObject(AObject *object) const
+    {
+        for (const AMigratedPool &pool : _hotReload->MigratedPools)
+        {
+            if (IsInPool(pool.Old, object))
+            {
+                size_t index = ((size_t)object - pool.Old.Start) / pool.Old.ElementSize;
+                return reinterpret_cast<AObject *>(pool.NewStart + index * pool.NewElementSize);
+            }
+        }
+
+        return object;
+    }
+
+    void AWorld::EndHotReload()
+    {
+        if (_hotReload == nullptr)
+        {
+            std::cout << "AWorld::EndHotReload | Error: No hot reload in progress" << std::endl;
+            return;
+        }
+
+        // whatever wasn't registered again is gone, along with its objects
+        std::vector<AllocatorMemoryHelper> removedEntityPools;
+        bool componentsRemoved = false;
+
+        for (auto &[name, helper] : _hotReload->AllocatorHelpers)
+        {
+            std::cout << "Type " << name.GetName() << " was not registered again, dropping its " << helper.Count << " objects" << std::endl;
+
+            if (_hotReload->EntityTypes.contains(name))
+            {
+                removedEntityPools.push_back(helper);
+            }
+            else
+            {
+                componentsRemoved = true;
+            }
+        }
+
+        bool entitiesMoved = !removedEntityPools.empty();
+        bool componentsMoved = componentsRemoved;
+        for (const AMigratedPool &pool : _hotReload->MigratedPools)
+        {
+            entitiesMoved |= pool.IsEntity;
+            componentsMoved |= !pool.IsEntity;
+        }
+
+        // the component bits follow the registration order
+        bool masksChanged = ComponentNames.size() != _hotReload->ComponentNames.size() ||
+                            !std::equal(ComponentNames.begin(), ComponentNames.end(), _hotReload->ComponentNames.begin());
+
+        // with nothing migrated or removed all pointers are still good
+        if (componentsMoved || entitiesMoved || masksChanged)
+        {
+            for (auto &[name, cdo] : CDOs)
+            {
+                const AllocatorMemoryHelper &helper = AllocatorHelpers.at(name);
+
+                if (dynamic_cast<AEntity *>(cdo.get()) != nullptr && (componentsMoved || masksChanged))
+                {
+                    for (size_t i = 0; i < helper.Count; i++)
+                    {
+                        AEntity *entity = reinterpret_cast<AEntity *>(helper.Start + i * helper.ElementSize);
+                        if (!entity->_isAlive)
+                        {
+                            continue;
+                        }
+
+                        bool changed = masksChanged;
+                        for (int j = (int)entity->Components.size() - 1; j >= 0; j--)
+                        {
+                            if (!CData.contains(entity->ComponentNames[j]))
+                            {
+                                entity->Components.erase(entity->Components.begin() + j);
+                                entity->ComponentNames.erase(entity->ComponentNames.begin() + j);
+                                changed = true;
+                                continue;
+                            }
+
+                            entity->Components[j] = static_cast<AComponent *>(RemapMigratedObject(entity->Components[j]));
+                        }
+
+                        if (changed)
+                        {
+                            entity->_componentMask = GetComponentMaskForComponents(entity->ComponentNames);
+                        }
+                    }
+                }
+                else if (dynamic_cast<AComponent *>(cdo.get()) != nullptr && entitiesMoved)
+                {
+                    for (size_t i = 0; i < helper.Count; i++)
+                    {
+                        AComponent *component = reinterpret_cast<AComponent *>(helper.Start + i * helper.ElementSize);
+                        if (!component->_isAlive || component->Owner == nullptr)
+                        {
+                            continue;
+                        }
+
+                        bool ownerRemoved = std::any_of(removedEntityPools.begin(), removedEntityPools.end(), [component](const AllocatorMemoryHelper &pool)
+                                                        { return IsInPool(pool, component->Owner); });
+
+                        if (ownerRemoved)
+                        {
+                            component->Owner = nullptr;
+                            component->MarkObjectDead();
+                        }
+                        else
+                        {
+                            component->Owner = static_cast<AEntity *>(RemapMigratedObject(component->Owner));
+                        }
+                    }
+                }
+            }
+        }
+
+        for (auto &[name, helper] : _hotReload->AllocatorHelpers)
+        {
+            ReleasePoolResourceRefs(_hotReload->CData.at(name), helper);
+            free((void *)helper.Start);
+            AMemoryTracker::Free(EMemoryTag::HotReload, helper.Limit * helper.ElementSize);
+        }
+
+        for (const AMigratedPool &pool : _hotReload->MigratedPools)
+        {
+            free((void *)pool.Old.Start);
+            AMemoryTracker::Free(EMemoryTag::HotReload, pool.Old.Limit * pool.Old.ElementSize);
+        }
+
+        _registryVersion++;
+
+        std::cout << "Hot reload done in " << (GetWorldTime() - _hotReload->StartTime) * 1000.0 << "ms, kept " << _hotReload->KeptPools
+                  << " pools, migrated " << _hotReload->MigratedPools.size() << " (" << _hotReload->MigratedObjects << " objects), dropped "
+                  << _hotReload->AllocatorHelpers.size() << std::endl;
+
+        _hotReload.reset();
+    }
+
+    bool AWorld::IsHotReloading() const
+    {
+        return _hotReload != nullptr;
+    }
+
+    void AWorld::OnPreHotReload()
+    {
+        ObjectCreateCommandsQueue.clear();
+        ObjectDestroyQueue.clear();
+        ObjectModifyQueue.clear();
+    }
+
+    void AWorld::OnPostHotReload()
+    {
+        // TODO: hack
+        _currentFrameTime = GetWorldTime();
+        _deltaTime = 0.0001f;
+        _lastFrameTime = _currentFrameTime - _deltaTime;
+        _frame++;
+    }
+
+    void AWorld::OnShutdown()
+    {
+        MainThreadProcessing = false;
+        RenderThreadProcessing = false;
     }
 
 } // namespace Atlantis
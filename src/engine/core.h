@@ -16,6 +16,7 @@
 #include <mutex>
 #include <thread>
 #include <atomic>
+#include <cassert>
 #include <iostream>
 
 #include <sol/sol.hpp>
@@ -25,6 +26,8 @@
 #include "helpers.h"
 #include "engine/system.h"
 #include "engine/profiling.h"
+#include "engine/memoryTracker.h"
+#include "engine/resources/resourceHolder.h"
 #include "./generated/core.gen.h"
 
 // TODO: arbitrary number, make it configurable and / or larger by default
@@ -57,31 +60,32 @@ namespace Atlantis
         // or ignore it (and potentially reuse it when creating new entities / components)
         bool _isAlive = true;
 
+        // CDOs are deleted through AObject, pooled objects are never destructed
+        virtual ~AObject() = default;
+
         virtual void MarkObjectDead();
 
+        // DEF_CLASS classes hide these with their own, see header_parser.py
+        static inline const AClassData _classData;
+
         virtual const AClassData &GetClassData() const
         {
-            static AClassData classData;
-            return classData;
+            return _classData;
         };
 
-        static AClassData &GetClassDataStatic()
+        static const AClassData &GetClassDataStatic()
         {
-            static AClassData classData;
-            return classData;
+            return _classData;
         }
 
         template <typename T>
         T GetProperty(const AName &name) const
         {
-            const AClassData &classData = GetClassData();
-            for (auto &prop : classData.Properties)
+            const APropertyData *prop = GetClassData().FindProperty(name);
+            if (prop != nullptr)
             {
-                if (prop.Name == name)
-                {
-                    T *val = reinterpret_cast<T *>((size_t)this + prop.Offset);
-                    return *val;
-                }
+                T *val = reinterpret_cast<T *>((size_t)this + prop->Offset);
+                return *val;
             }
 
             T tmp;
@@ -91,21 +95,59 @@ namespace Atlantis
         template <typename T>
         void SetProperty(const AName &name, T value)
         {
-            const AClassData &classData = GetClassData();
-            for (auto &prop : classData.Properties)
+            const APropertyData *prop = GetClassData().FindProperty(name);
+            if (prop != nullptr)
             {
-                if (prop.Name == name)
-                {
-                    T *val = reinterpret_cast<T *>((size_t)this + prop.Offset);
-                    *val = value;
-                    break;
-                }
+                T *val = reinterpret_cast<T *>((size_t)this + prop->Offset);
+                *val = value;
+            }
+        }
+
+        // resolves name once for GetProperty / SetProperty by handle, e.g. in loops
+        // over many objects of the same class
+        APropertyHandle GetPropertyHandle(const AName &name) const
+        {
+            return GetClassData().GetPropertyHandle(name);
+        }
+
+        // handles of another class are only checked in debug builds
+        template <typename T>
+        T GetProperty(const APropertyHandle &handle) const
+        {
+            assert(!handle.IsValid() || handle.IsFor(GetClassData()));
+
+            if (!handle.IsValid())
+            {
+                T tmp;
+                return tmp;
+            }
+
+            return *handle.GetPtr<T>(this);
+        }
+
+        template <typename T>
+        void SetProperty(const APropertyHandle &handle, T value)
+        {
+            assert(!handle.IsValid() || handle.IsFor(GetClassData()));
+
+            if (handle.IsValid())
+            {
+                *handle.GetPtr<T>(this) = value;
             }
         }
 
         virtual nlohmann::json Serialize();
 
         virtual void Deserialize(const nlohmann::json &json);
+
+        // generated per class by the header parser, these are the fallbacks
+        // for classes without generated code
+        virtual void SerializeProperties(nlohmann::json &properties, const AObject *cdoObject) const;
+
+        // index is the property's position in GetClassData().Properties
+        virtual void DeserializeProperty(size_t index, const nlohmann::json &value);
+
+        void DeserializeResourceHandle(size_t index, const nlohmann::json &value);
     };
 
     struct AEntity;
@@ -235,21 +277,6 @@ namespace Atlantis
         }
     };
 
-    struct AResourceHolder
-    {
-        AWorld *World = nullptr;
-        std::unordered_map<std::string, std::unique_ptr<AResource>> Resources;
-
-        AResourceHolder(AWorld *world)
-        {
-            World = world;
-        }
-
-        AResourceHandle GetTexture(std::string path);
-
-        void* GetResourcePtr(std::string path);
-    };
-
     template <typename T>
     struct AObjPtr
     {
@@ -333,7 +360,12 @@ namespace Atlantis
 
     struct AWorld
     {
-        std::map<AName, AClassData, ANameComparer> CData;
+        // first so it's destroyed last, CDOs and systems can hold handles into it
+        AResourceHolder ResourceHolder = AResourceHolder(this);
+
+        // shared with the types themselves, generated class data lives in the lib
+        // that registered it and dynamic class data with its owner
+        std::map<AName, const AClassData *, ANameComparer> CData;
 
         std::map<AName, std::unique_ptr<AObject>, ANameComparer> CDOs;
         std::map<AName, std::vector<std::unique_ptr<AObject, no_deleter>>, ANameComparer> ObjectLists;
@@ -342,15 +374,13 @@ namespace Atlantis
         // TEMP for testing
         std::vector<std::unique_ptr<ASystem>> SystemsRenderThread;
         std::mutex RenderThreadMutex;
-        std::mutex ProfilingMutex;
         const std::thread::id MAIN_THREAD_ID = std::this_thread::get_id();
         std::vector<std::function<void()>> RenderThreadCallQueue;
 
-        AResourceHolder ResourceHolder = AResourceHolder(this);
-
         std::vector<std::function<void()>> ObjectCreateCommandsQueue;
         std::vector<std::function<void()>> ObjectModifyQueue;
         std::vector<AObjPtr<AObject>> ObjectDestroyQueue;
+        std::vector<std::function<void()>> SyncPointQueue;
 
         std::vector<AName> ComponentNames;
 
@@ -366,6 +396,7 @@ namespace Atlantis
             size_t Count;
             size_t Limit;
             size_t Increment;
+            size_t ElementSize;
         };
 
         std::map<AName, AllocatorMemoryHelper, ANameComparer> AllocatorHelpers;
@@ -373,45 +404,30 @@ namespace Atlantis
 
         /*void RegisterClass(AObject *obj)
         {
-            AClassData data = obj->GetClassData();
-            CData.emplace(data.Name, data);
+            const AClassData &data = obj->GetClassData();
+            CData.emplace(data.Name, &data);
 
             CDOs.emplace(data.Name, std::make_shared<AObject>(*obj));
         }*/
 
         template <typename T, size_t Amount, size_t Increment = Amount>
         void RegisterDefault(AName name = AName::None())
+        {
+            RegisterDefault<T>(Amount, Increment, name);
+        }
+
+        // runtime sized pools, for when the amount isn't known at compile time
+        template <typename T>
+        void RegisterDefault(size_t amount, size_t increment, AName name = AName::None())
         {
             T obj;
-            AClassData data = obj.GetClassData();
+            const AClassData &data = obj.GetClassData();
             AName objName = name == AName::None() ? data.Name : name;
 
-            CData.insert_or_assign(objName, data);
-
-            CDOs.insert_or_assign(objName, std::make_unique<T>(obj));
-
-            size_t memBlock = (size_t)malloc(Amount * data.Size);
-
-            AllocatorMemoryHelper allocatorHelper;
-            allocatorHelper.Start = memBlock;
-            allocatorHelper.Count = 0;
-            allocatorHelper.Limit = Amount;
-            allocatorHelper.Increment = Increment;
-
-            AllocatorHelpers.insert_or_assign(objName, allocatorHelper);
-            // ObjAllocStart.emplace(data.Name, memBlock);
-
             T *objPtr = &obj;
-            if (dynamic_cast<AComponent *>(objPtr) != nullptr)
-            {
-                if (std::find(ComponentNames.begin(), ComponentNames.end(), objName) == ComponentNames.end())
-                {
-                    ComponentNames.push_back(objName);
-                }
-            }
+            bool isComponent = dynamic_cast<AComponent *>(objPtr) != nullptr;
 
-            ObjectLists[objName].reserve(allocatorHelper.Limit);
-            DeadObjects[objName].reserve(allocatorHelper.Limit);
+            RegisterPool(objName, data, std::make_unique<T>(obj), isComponent, amount, increment);
         }
 
         template <typename T>
@@ -420,6 +436,20 @@ namespace Atlantis
             RegisterDefault<T, 10000>(name);
         }
 
+        // types whose layout is only known at runtime, see CDynamicComponent
+        // data.Size bytes of cdo get copied into every new object, data has to
+        // outlive the world
+        void RegisterDynamic(const AClassData &data, std::unique_ptr<AObject> cdo, size_t amount = 10000, size_t increment = 10000);
+
+        // pooled objects are memcpy'd from their CDO and never destructed, these keep
+        // the references of the resource handles among their properties right
+        // acquire after the memcpy, release when the object dies or its pool goes away
+        static void AcquireResourceRefs(const AClassData &classData, void *object);
+        static void ReleaseResourceRefs(const AClassData &classData, void *object);
+
+        // a reused object gets the CDO's handles again
+        static void CopyResourceRefs(const AClassData &classData, void *object, const void *cdo);
+
         template <typename T>
         const T *GetCDO(const AName &name)
         {
@@ -432,7 +462,7 @@ namespace Atlantis
             _registryVersion++;
             const T *CDO = GetCDO<T>(name);
 
-            AClassData classData = CDO->GetClassData();
+            const AClassData &classData = CDO->GetClassData();
 
             // reuse dead objects
             if (DeadObjects[name].size() > 0)
@@ -442,6 +472,7 @@ namespace Atlantis
 
                 T *obj = static_cast<T *>(objPtr.Get(name, false));
                 obj->_isAlive = true;
+                CopyResourceRefs(classData, obj, CDO);
 
                 return obj;
             }
@@ -452,8 +483,10 @@ namespace Atlantis
             {
                 std::cout << "Reallocating memory for type " << classData.Name.GetName() << " from " << allocatorHelper.Limit << " to " << allocatorHelper.Limit + allocatorHelper.Increment << std::endl;
 
+                AMemoryTracker::Free(EMemoryTag::ObjectPools, allocatorHelper.Limit * classData.Size);
                 allocatorHelper.Limit += allocatorHelper.Increment;
                 allocatorHelper.Start = (size_t)realloc((void *)allocatorHelper.Start, allocatorHelper.Limit * classData.Size);
+                AMemoryTracker::Allocate(EMemoryTag::ObjectPools, allocatorHelper.Limit * classData.Size);
 
                 ObjectLists[name].clear();
                 ObjectLists[name].reserve(allocatorHelper.Limit);
@@ -494,6 +527,7 @@ namespace Atlantis
 
             // void *cpy = malloc(classData.Size);
             memcpy(cpy, (void *)CDO, classData.Size);
+            AcquireResourceRefs(classData, cpy);
 
             T *cpy_T = static_cast<T *>(cpy);
 
@@ -561,16 +595,20 @@ namespace Atlantis
 
         float GetDeltaTime() const;
 
+        // > 0 makes every frame advance by exactly this much, for reproducible runs
+        void SetFixedDeltaTime(float deltaTime);
+
+        uint GetFrame() const;
+
         bool IsMainThread() const;
         
         uint GetRegistryVersion() const;
 
+        // gives the pools' handle references back like Clear, the resource holder is
+        // still alive until the members are gone
         ~AWorld()
         {
-            for (auto thing : AllocatorHelpers)
-            {
-                free((void *)thing.second.Start);
-            }
+            Clear();
         }
 
         void RegisterSystem(ASystem *system, const std::vector<AName> &beforeLabels = {});
@@ -620,8 +658,34 @@ namespace Atlantis
         
         void ProcessSystemsRenderThread();
 
+        struct ASystemStatsEntry
+        {
+            std::string Name;
+            bool IsRenderSystem = false;
+            bool IsTimesliced = false;
+            ASystemStats Stats;
+        };
+
+        // copies of the timings of all systems, in processing order (main thread first)
+        // SyncEntities comes first, queued system work shows up there
+        std::vector<ASystemStatsEntry> GetSystemStats();
+
+        // time spent draining the object queues in SyncEntities
+        ASystemStats SyncStats;
+
+        // pool usage of every registered type, use it to size the RegisterDefault amounts
+        // reads the live pools, main thread only
+        std::vector<APoolStats> GetPoolStats() const;
+
+        // GetPoolStats as of the last sync point, for the render thread
+        std::vector<APoolStats> PoolStatsSnapshot;
+
         void QueueRenderThreadCall(std::function<void()> lambda);
 
+        // runs once at the end of the next SyncEntities, while the render thread waits
+        // and all queued changes are applied, e.g. to copy the world for a save
+        void QueueSyncPoint(std::function<void()> lambda);
+
         void SyncEntities();
 
         const std::vector<std::unique_ptr<AObject, no_deleter>> &GetObjectsByName(const AName &objectName);
@@ -638,6 +702,17 @@ namespace Atlantis
 
         void OnPreHotReload();
 
+        // hot reload without tearing the world down, BeginHotReload has to run while the
+        // old game lib is still loaded, EndHotReload once the new one registered its types
+        // types that get registered again with the same layout keep their pool as is,
+        // only their vtable pointers get patched, changed types get copied into a new
+        // pool property by property, objects keep their uids either way
+        void BeginHotReload();
+
+        void EndHotReload();
+
+        bool IsHotReloading() const;
+
         void OnPostHotReload();
 
         void OnShutdown();
@@ -807,10 +882,62 @@ namespace Atlantis
         }
 
 private:
+        void ProcessSystem(ASystem *system);
+
+        // non template part of RegisterDefault
+        void RegisterPool(const AName &name, const AClassData &data, std::unique_ptr<AObject> cdo, bool isComponent, size_t amount, size_t increment);
+
+        // hot reload, see BeginHotReload
+        void KeepPool(const AName &name, size_t increment);
+
+        void MigratePool(const AName &name, size_t amount, size_t increment);
+
+        // address of a migrated object in its new pool, anything else is returned as is
+        AObject *RemapMigratedObject(AObject *object) const;
+
+        // a pool that got copied into a new layout during hot reload
+        struct AMigratedPool
+        {
+            AllocatorMemoryHelper Old;
+            size_t NewStart = 0;
+            size_t NewElementSize = 0;
+            bool IsEntity = false;
+        };
+
+        // the world as it was before BeginHotReload, types that get registered again
+        // take their pools from here, whatever is left by EndHotReload is gone
+        struct AHotReloadState
+        {
+            // copies, the old lib's class data goes away with it
+            std::map<AName, AClassData, ANameComparer> CData;
+            std::map<AName, AllocatorMemoryHelper, ANameComparer> AllocatorHelpers;
+            std::map<AName, std::vector<std::unique_ptr<AObject, no_deleter>>, ANameComparer> ObjectLists;
+            std::map<AName, std::vector<AObjPtr<AObject>>> DeadObjects;
+            std::vector<AName> ComponentNames;
+
+            // collected while the old lib was still loaded, the objects of removed
+            // types can't be asked anymore
+            std::set<AName, ANameComparer> EntityTypes;
+
+            std::vector<AMigratedPool> MigratedPools;
+            size_t KeptPools = 0;
+            size_t MigratedObjects = 0;
+
+            double StartTime = 0.0;
+        };
+
+        std::unique_ptr<AHotReloadState> _hotReload;
+
+        // samples the memory we can't track allocation by allocation
+        void UpdateMemoryStats();
+
+        void FillPoolStats(std::vector<APoolStats> &pools) const;
+
         double _lastFrameTime = 0.0;
         double _currentFrameTime = 0.0;
 
         float _deltaTime = 0.001f;
+        float _fixedDeltaTime = 0.0f;
 
         uint _frame = 0;
         uint _registryVersion = 0;
@@ -0,0 +1,115 @@
+#include "engine/dynamicComponent.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <new>
+
+namespace Atlantis
+{
+    namespace
+    {
+        size_t AlignUp(size_t value, size_t alignment)
+        {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+
+        // size and alignment of the kinds a dynamic component can hold
+        bool GetFieldLayout(EPropertyKind kind, size_t &size, size_t &alignment)
+        {
+            switch (kind)
+            {
+            case EPropertyKind::Bool:
+                size = sizeof(bool);
+                alignment = alignof(bool);
+                return true;
+            case EPropertyKind::Int:
+                size = sizeof(int);
+                alignment = alignof(int);
+                return true;
+            case EPropertyKind::Float:
+                size = sizeof(float);
+                alignment = alignof(float);
+                return true;
+            case EPropertyKind::Double:
+                size = sizeof(double);
+                alignment = alignof(double);
+                return true;
+            case EPropertyKind::Color:
+                size = sizeof(Color);
+                alignment = alignof(Color);
+                return true;
+            default:
+                return false;
+            }
+        }
+    }
+
+    const AClassData &CDynamicComponent::GetClassData() const
+    {
+        if (DynamicClassData == nullptr)
+        {
+            return AComponent::GetClassData();
+        }
+
+        return *DynamicClassData;
+    }
+
+    bool CDynamicComponent::MakeClassData(const AName &name, const std::vector<AField> &fields, AClassData &outData)
+    {
+        AClassData data;
+        data.Name = name;
+
+        size_t offset = sizeof(CDynamicComponent);
+        size_t maxAlignment = alignof(CDynamicComponent);
+
+        for (const AField &field : fields)
+        {
+            APropertyData propData;
+            propData.Name = field.Name;
+            propData.Type = field.Type;
+            propData.Kind = GetPropertyKind(propData.Type);
+
+            size_t alignment = 0;
+            if (!GetFieldLayout(propData.Kind, propData.Size, alignment))
+            {
+                std::cout << "CDynamicComponent::MakeClassData | Error: " << name.GetName() << "." << field.Name << " has type " << field.Type << ", only bool, int, float, double and Color are allowed" << std::endl;
+                return false;
+            }
+
+            for (const APropertyData &other : data.Properties)
+            {
+                if (other.Name == propData.Name)
+                {
+                    std::cout << "CDynamicComponent::MakeClassData | Error: " << name.GetName() << "." << field.Name << " is declared twice" << std::endl;
+                    return false;
+                }
+            }
+
+            offset = AlignUp(offset, alignment);
+            propData.Offset = offset;
+            offset += propData.Size;
+
+            maxAlignment = std::max(maxAlignment, alignment);
+
+            data.Properties.push_back(propData);
+        }
+
+        data.Size = AlignUp(offset, maxAlignment);
+        data.BuildPropertyIndex();
+
+        outData = data;
+        return true;
+    }
+
+    std::unique_ptr<AObject> CDynamicComponent::MakeCDO(const AClassData *classData)
+    {
+        // freed through CDynamicComponent's operator delete, which matches this
+        void *memory = ::operator new(classData->Size);
+        memset(memory, 0, classData->Size);
+
+        CDynamicComponent *cdo = new (memory) CDynamicComponent();
+        cdo->DynamicClassData = classData;
+
+        return std::unique_ptr<AObject>(cdo);
+    }
+}
@@ -0,0 +1,48 @@
+#ifndef ATLANTIS_ENGINE_DYNAMICCOMPONENT_H
+#define ATLANTIS_ENGINE_DYNAMICCOMPONENT_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "engine/core.h"
+
+namespace Atlantis
+{
+    // a component type declared at runtime, e.g. by a script
+    //
+    // the properties are stored right after the object, so objects of the type get
+    // pooled, copied from their CDO and serialized like any other component
+    // only trivially copyable kinds are allowed, bool, int, float, double and Color
+    //
+    // every object points at the AClassData of its type, it has to outlive the CDO
+    // and all objects of the type
+    struct CDynamicComponent : public AComponent
+    {
+        const AClassData *DynamicClassData = nullptr;
+
+        virtual const AClassData &GetClassData() const override;
+
+        // a property of a dynamic component, types are spelled like in C++ ("int", "float")
+        struct AField
+        {
+            std::string Name;
+            std::string Type;
+        };
+
+        // lays the fields out in declaration order after the object, returns false if
+        // a type isn't allowed or a name is used twice
+        static bool MakeClassData(const AName &name, const std::vector<AField> &fields, AClassData &outData);
+
+        // a CDO the size of classData with all properties zeroed
+        static std::unique_ptr<AObject> MakeCDO(const AClassData *classData);
+
+        // CDOs are bigger than the class, MakeCDO allocates them with the unsized
+        // ::operator new so deleting one has to free it with the unsized delete too
+        static void operator delete(void *ptr)
+        {
+            ::operator delete(ptr);
+        }
+    };
+}
+
+#endif // ATLANTIS_ENGINE_DYNAMICCOMPONENT_H
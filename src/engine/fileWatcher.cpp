@@ -0,0 +1,338 @@
+#include "engine/fileWatcher.h"
+#include <iostream>
+
+#if defined(__linux__)
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace Atlantis
+{
+    AFileWatcher::~AFileWatcher()
+    {
+        Stop();
+    }
+
+    void AFileWatcher::Watch(const std::filesystem::path &directory, bool recursive, ACallback callback)
+    {
+        if (Running)
+        {
+            std::cout << "AFileWatcher::Watch | Error: Can't add watches while running" << std::endl;
+            return;
+        }
+
+        std::error_code error;
+        if (!std::filesystem::is_directory(directory, error))
+        {
+            std::cout << "AFileWatcher::Watch | Error: " << directory << " is not a directory" << std::endl;
+            return;
+        }
+
+        AWatch watch;
+        watch.Directory = directory;
+        watch.Recursive = recursive;
+        watch.Callback = callback;
+        Watches.push_back(watch);
+    }
+
+    void AFileWatcher::Start()
+    {
+        if (Running.exchange(true))
+        {
+            return;
+        }
+
+        if (StartInotify())
+        {
+            UsingInotify = true;
+            Thread = std::thread(&AFileWatcher::ThreadInotify, this);
+        }
+        else
+        {
+            UsingInotify = false;
+            Thread = std::thread(&AFileWatcher::ThreadPoll, this);
+        }
+    }
+
+    void AFileWatcher::Stop()
+    {
+        if (!Running.exchange(false))
+        {
+            return;
+        }
+
+        {
+            std::lock_guard lock(StopMutex);
+            StopCondition.notify_all();
+        }
+
+#if defined(__linux__)
+        if (WakeFds[1] != -1)
+        {
+            char wake = 0;
+            if (write(WakeFds[1], &wake, 1) == -1)
+            {
+                std::cout << "AFileWatcher::Stop | Error: Could not wake the watcher thread" << std::endl;
+            }
+        }
+#endif
+
+        if (Thread.joinable())
+        {
+            Thread.join();
+        }
+
+#if defined(__linux__)
+        for (int fd : {InotifyFd, WakeFds[0], WakeFds[1]})
+        {
+            if (fd != -1)
+            {
+                close(fd);
+            }
+        }
+#endif
+
+        InotifyFd = -1;
+        WakeFds[0] = -1;
+        WakeFds[1] = -1;
+        InotifyWatches.clear();
+    }
+
+    void AFileWatcher::Update()
+    {
+        std::vector<std::pair<size_t, std::filesystem::path>> settled;
+
+        {
+            std::lock_guard lock(PendingMutex);
+            if (PendingChanges.empty())
+            {
+                return;
+            }
+
+            auto now = std::chrono::steady_clock::now();
+            for (auto it = PendingChanges.begin(); it != PendingChanges.end();)
+            {
+                if (now - it->second.LastEvent >= std::chrono::milliseconds(DebounceMs))
+                {
+                    settled.emplace_back(it->second.WatchIndex, it->first);
+                    it = PendingChanges.erase(it);
+                }
+                else
+                {
+                    it++;
+                }
+            }
+        }
+
+        for (const auto &[watchIndex, path] : settled)
+        {
+            Watches[watchIndex].Callback(path);
+        }
+    }
+
+    bool AFileWatcher::IsUsingInotify() const
+    {
+        return UsingInotify;
+    }
+
+    void AFileWatcher::AddChange(size_t watchIndex, const std::filesystem::path &path)
+    {
+        std::lock_guard lock(PendingMutex);
+
+        APendingChange &change = PendingChanges[path];
+        change.WatchIndex = watchIndex;
+        change.LastEvent = std::chrono::steady_clock::now();
+    }
+
+    bool AFileWatcher::StartInotify()
+    {
+#if defined(__linux__)
+        InotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (InotifyFd == -1)
+        {
+            std::cout << "AFileWatcher::StartInotify | Error: inotify isn't available, polling instead" << std::endl;
+            return false;
+        }
+
+        if (pipe2(WakeFds, O_NONBLOCK | O_CLOEXEC) == -1)
+        {
+            std::cout << "AFileWatcher::StartInotify | Error: Could not create wake pipe, polling instead" << std::endl;
+            close(InotifyFd);
+            InotifyFd = -1;
+            return false;
+        }
+
+        // added before the thread runs, so nothing written after Start gets missed
+        for (size_t i = 0; i < Watches.size(); i++)
+        {
+            AddInotifyWatch(i, Watches[i].Directory);
+        }
+
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    void AFileWatcher::AddInotifyWatch(size_t watchIndex, const std::filesystem::path &directory)
+    {
+#if defined(__linux__)
+        int wd = inotify_add_watch(InotifyFd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+        if (wd == -1)
+        {
+            std::cout << "AFileWatcher::AddInotifyWatch | Error: Could not watch " << directory << std::endl;
+            return;
+        }
+
+        InotifyWatches[wd] = {watchIndex, directory};
+
+        if (!Watches[watchIndex].Recursive)
+        {
+            return;
+        }
+
+        std::error_code error;
+        for (const auto &entry : std::filesystem::directory_iterator(directory, error))
+        {
+            if (entry.is_directory(error))
+            {
+                AddInotifyWatch(watchIndex, entry.path());
+            }
+        }
+#endif
+    }
+
+    void AFileWatcher::ThreadInotify()
+    {
+#if defined(__linux__)
+        pollfd fds[2] = {{InotifyFd, POLLIN, 0}, {WakeFds[0], POLLIN, 0}};
+
+        alignas(inotify_event) char buffer[4096];
+
+        while (Running)
+        {
+            if (poll(fds, 2, -1) == -1)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+
+                std::cout << "AFileWatcher::ThreadInotify | Error: poll failed, no more file changes will be reported" << std::endl;
+                return;
+            }
+
+            if (fds[1].revents != 0)
+            {
+                return;
+            }
+
+            ssize_t length;
+            while ((length = read(InotifyFd, buffer, sizeof(buffer))) > 0)
+            {
+                for (char *ptr = buffer; ptr < buffer + length;)
+                {
+                    const inotify_event *event = reinterpret_cast<const inotify_event *>(ptr);
+                    ptr += sizeof(inotify_event) + event->len;
+
+                    auto it = InotifyWatches.find(event->wd);
+                    if (it == InotifyWatches.end())
+                    {
+                        continue;
+                    }
+
+                    if (event->mask & IN_IGNORED)
+                    {
+                        InotifyWatches.erase(it);
+                        continue;
+                    }
+
+                    if (event->len == 0)
+                    {
+                        continue;
+                    }
+
+                    size_t watchIndex = it->second.first;
+                    std::filesystem::path path = it->second.second / event->name;
+
+                    if (event->mask & IN_ISDIR)
+                    {
+                        if (Watches[watchIndex].Recursive)
+                        {
+                            AddInotifyWatch(watchIndex, path);
+                        }
+                    }
+                    else if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO))
+                    {
+                        AddChange(watchIndex, path);
+                    }
+                }
+            }
+        }
+#endif
+    }
+
+    void AFileWatcher::ThreadPoll()
+    {
+        std::map<std::filesystem::path, std::filesystem::file_time_type> knownFiles;
+        bool firstScan = true;
+
+        auto scanFile = [&](size_t watchIndex, const std::filesystem::directory_entry &entry)
+        {
+            std::error_code error;
+            if (!entry.is_regular_file(error))
+            {
+                return;
+            }
+
+            std::filesystem::file_time_type time = entry.last_write_time(error);
+            if (error)
+            {
+                return;
+            }
+
+            auto it = knownFiles.find(entry.path());
+            if (it == knownFiles.end() || it->second != time)
+            {
+                knownFiles[entry.path()] = time;
+
+                // the first scan only learns what's there
+                if (!firstScan)
+                {
+                    AddChange(watchIndex, entry.path());
+                }
+            }
+        };
+
+        while (Running)
+        {
+            for (size_t i = 0; i < Watches.size(); i++)
+            {
+                std::error_code error;
+                if (Watches[i].Recursive)
+                {
+                    for (const auto &entry : std::filesystem::recursive_directory_iterator(Watches[i].Directory, error))
+                    {
+                        scanFile(i, entry);
+                    }
+                }
+                else
+                {
+                    for (const auto &entry : std::filesystem::directory_iterator(Watches[i].Directory, error))
+                    {
+                        scanFile(i, entry);
+                    }
+                }
+            }
+
+            firstScan = false;
+
+            std::unique_lock lock(StopMutex);
+            StopCondition.wait_for(lock, std::chrono::milliseconds(PollIntervalMs), [this]()
+                                   { return !Running; });
+        }
+    }
+}
@@ -0,0 +1,94 @@
+#ifndef ATLANTIS_ENGINE_FILEWATCHER_H
+#define ATLANTIS_ENGINE_FILEWATCHER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace Atlantis
+{
+    // reports files that got written to in watched directories
+    //
+    // on linux a background thread blocks on inotify, so nothing is spent on files that
+    // don't change, elsewhere (or if inotify isn't available) it polls modification
+    // times every PollIntervalMs
+    // a change is only reported once the file has been left alone for DebounceMs, so a
+    // linker or an editor writing a file in several steps triggers a single callback
+    struct AFileWatcher
+    {
+        using ACallback = std::function<void(const std::filesystem::path &path)>;
+
+        int DebounceMs = 250;
+        int PollIntervalMs = 500;
+
+        ~AFileWatcher();
+
+        // has to be called before Start, recursive watches subdirectories too,
+        // including the ones created later
+        void Watch(const std::filesystem::path &directory, bool recursive, ACallback callback);
+
+        void Start();
+
+        void Stop();
+
+        // runs the callbacks of changes that have settled, callbacks only ever run here
+        void Update();
+
+        bool IsUsingInotify() const;
+
+    private:
+        struct AWatch
+        {
+            std::filesystem::path Directory;
+            bool Recursive = false;
+            ACallback Callback;
+        };
+
+        struct APendingChange
+        {
+            size_t WatchIndex = 0;
+            std::chrono::steady_clock::time_point LastEvent;
+        };
+
+        bool StartInotify();
+
+        void AddInotifyWatch(size_t watchIndex, const std::filesystem::path &directory);
+
+        void ThreadInotify();
+
+        void ThreadPoll();
+
+        // called by the watcher thread
+        void AddChange(size_t watchIndex, const std::filesystem::path &path);
+
+        std::vector<AWatch> Watches;
+
+        std::thread Thread;
+        std::atomic<bool> Running = false;
+        std::atomic<bool> UsingInotify = false;
+
+        std::map<std::filesystem::path, APendingChange> PendingChanges;
+        std::mutex PendingMutex;
+
+        // wakes the polling thread up on Stop
+        std::condition_variable StopCondition;
+        std::mutex StopMutex;
+
+        // inotify descriptor and the pipe that wakes its thread up on Stop
+        int InotifyFd = -1;
+        int WakeFds[2] = {-1, -1};
+
+        // inotify watch descriptor -> watch index and directory, only touched by the
+        // watcher thread once it runs
+        std::unordered_map<int, std::pair<size_t, std::filesystem::path>> InotifyWatches;
+    };
+}
+
+#endif // ATLANTIS_ENGINE_FILEWATCHER_H
@@ -0,0 +1,124 @@
+#include "engine/memoryTracker.h"
+#include <array>
+#include <atomic>
+
+namespace Atlantis
+{
+    namespace
+    {
+        struct AMemoryTagCounters
+        {
+            std::atomic<size_t> LiveBytes = 0;
+            std::atomic<size_t> PeakBytes = 0;
+
+            std::atomic<uint64_t> TotalAllocations = 0;
+            std::atomic<uint64_t> TotalFrees = 0;
+            std::atomic<uint64_t> TotalBytes = 0;
+
+            // main thread only, totals at the start of the current frame
+            uint64_t FrameStartAllocations = 0;
+            uint64_t FrameStartBytes = 0;
+
+            std::atomic<uint64_t> FrameAllocations = 0;
+            std::atomic<uint64_t> FrameBytes = 0;
+        };
+
+        std::array<AMemoryTagCounters, (size_t)EMemoryTag::Count> &GetCounters()
+        {
+            static std::array<AMemoryTagCounters, (size_t)EMemoryTag::Count> counters;
+            return counters;
+        }
+
+        void UpdatePeak(AMemoryTagCounters &counters, size_t live)
+        {
+            size_t peak = counters.PeakBytes.load(std::memory_order_relaxed);
+            while (live > peak && !counters.PeakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+            {
+            }
+        }
+    }
+
+    void AMemoryTracker::Allocate(EMemoryTag tag, size_t bytes)
+    {
+        AMemoryTagCounters &counters = GetCounters()[(size_t)tag];
+
+        size_t live = counters.LiveBytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+        counters.TotalAllocations.fetch_add(1, std::memory_order_relaxed);
+        counters.TotalBytes.fetch_add(bytes, std::memory_order_relaxed);
+
+        UpdatePeak(counters, live);
+    }
+
+    void AMemoryTracker::Free(EMemoryTag tag, size_t bytes)
+    {
+        AMemoryTagCounters &counters = GetCounters()[(size_t)tag];
+
+        counters.LiveBytes.fetch_sub(bytes, std::memory_order_relaxed);
+        counters.TotalFrees.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void AMemoryTracker::SetLiveBytes(EMemoryTag tag, size_t bytes)
+    {
+        AMemoryTagCounters &counters = GetCounters()[(size_t)tag];
+
+        // growth of a sampled tag counts as allocated bytes for the frame rates
+        size_t previous = counters.LiveBytes.exchange(bytes, std::memory_order_relaxed);
+        if (bytes > previous)
+        {
+            counters.TotalBytes.fetch_add(bytes - previous, std::memory_order_relaxed);
+        }
+
+        UpdatePeak(counters, bytes);
+    }
+
+    void AMemoryTracker::MarkFrame()
+    {
+        for (AMemoryTagCounters &counters : GetCounters())
+        {
+            uint64_t allocations = counters.TotalAllocations.load(std::memory_order_relaxed);
+            uint64_t bytes = counters.TotalBytes.load(std::memory_order_relaxed);
+
+            counters.FrameAllocations.store(allocations - counters.FrameStartAllocations, std::memory_order_relaxed);
+            counters.FrameBytes.store(bytes - counters.FrameStartBytes, std::memory_order_relaxed);
+
+            counters.FrameStartAllocations = allocations;
+            counters.FrameStartBytes = bytes;
+        }
+    }
+
+    AMemoryTagStats AMemoryTracker::GetStats(EMemoryTag tag)
+    {
+        const AMemoryTagCounters &counters = GetCounters()[(size_t)tag];
+
+        AMemoryTagStats stats;
+        stats.LiveBytes = counters.LiveBytes.load(std::memory_order_relaxed);
+        stats.PeakBytes = counters.PeakBytes.load(std::memory_order_relaxed);
+        stats.TotalAllocations = counters.TotalAllocations.load(std::memory_order_relaxed);
+        stats.TotalFrees = counters.TotalFrees.load(std::memory_order_relaxed);
+        stats.FrameAllocations = counters.FrameAllocations.load(std::memory_order_relaxed);
+        stats.FrameBytes = counters.FrameBytes.load(std::memory_order_relaxed);
+
+        return stats;
+    }
+
+    const char *AMemoryTracker::GetTagName(EMemoryTag tag)
+    {
+        switch (tag)
+        {
+        case EMemoryTag::ObjectPools:
+            return "ObjectPools";
+        case EMemoryTag::ObjectLists:
+            return "ObjectLists";
+        case EMemoryTag::Resources:
+            return "Resources";
+        case EMemoryTag::HotReload:
+            return "HotReload";
+        case EMemoryTag::Lua:
+            return "Lua";
+        case EMemoryTag::Profiler:
+            return "Profiler";
+        default:
+            return "Unknown";
+        }
+    }
+}
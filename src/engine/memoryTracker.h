@@ -0,0 +1,80 @@
+#ifndef ATLANTIS_ENGINE_MEMORYTRACKER_H
+#define ATLANTIS_ENGINE_MEMORYTRACKER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace Atlantis
+{
+    enum class EMemoryTag : uint8_t
+    {
+        // blocks allocated by AWorld::RegisterDefault
+        ObjectPools,
+        // ObjectLists / DeadObjects vectors
+        ObjectLists,
+        // loaded textures
+        Resources,
+        // world state kept between PreHotReload and PostHotReload
+        HotReload,
+        // lua state
+        Lua,
+        // profiler thread buffers
+        Profiler,
+        Count
+    };
+
+    struct AMemoryTagStats
+    {
+        size_t LiveBytes = 0;
+        size_t PeakBytes = 0;
+
+        uint64_t TotalAllocations = 0;
+        uint64_t TotalFrees = 0;
+
+        // allocations made during the last completed frame
+        uint64_t FrameAllocations = 0;
+        uint64_t FrameBytes = 0;
+    };
+
+    // usage of the pool of one registered type, see AWorld::GetPoolStats
+    struct APoolStats
+    {
+        std::string Name;
+        size_t ElementSize = 0;
+
+        // slots allocated, slots handed out so far and slots waiting to be reused
+        size_t Capacity = 0;
+        size_t Used = 0;
+        size_t Dead = 0;
+
+        size_t ReservedBytes = 0;
+        size_t LiveBytes = 0;
+
+        // ObjectLists / DeadObjects entries for this type
+        size_t BookkeepingBytes = 0;
+
+        // share of the used slots that are dead, i.e. holes iteration still walks over
+        float Fragmentation = 0.0f;
+    };
+
+    // all functions are thread safe, counters are relaxed atomics
+    struct AMemoryTracker
+    {
+        static void Allocate(EMemoryTag tag, size_t bytes);
+
+        static void Free(EMemoryTag tag, size_t bytes);
+
+        // for memory we can only sample, like the lua state or std containers
+        static void SetLiveBytes(EMemoryTag tag, size_t bytes);
+
+        // closes the current frame for the per frame rates, only call from the main thread
+        static void MarkFrame();
+
+        static AMemoryTagStats GetStats(EMemoryTag tag);
+
+        static const char *GetTagName(EMemoryTag tag);
+    };
+}
+
+#endif // ATLANTIS_ENGINE_MEMORYTRACKER_H
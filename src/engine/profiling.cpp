@@ -1,11 +1,472 @@
 #include "engine/profiling.h"
 #include "engine/core.h"
+#include "engine/traceWriter.h"
+#include "engine/memoryTracker.h"
+#include <iostream>
+#include <map>
 #include "timer.h"
 #include "fmt/core.h"
 #include "raylib.h"
 
 namespace Atlantis
 {
+    namespace
+    {
+        struct AProfilerState
+        {
+            std::mutex BuffersMutex;
+            std::vector<std::unique_ptr<AProfileThreadBuffer>> Buffers;
+
+            // consumer only, frames being built per thread index
+            std::vector<AProfileThreadFrame> CurrentFrames;
+
+            std::mutex FramesMutex;
+            std::vector<AProfileThreadFrame> LastFrames;
+
+            // tick -> nanosecond calibration
+            uint64_t StartTicks = GetProfilerTicks();
+            std::chrono::steady_clock::time_point StartTime = std::chrono::steady_clock::now();
+            std::atomic<double> NsPerTick = 1.0;
+
+            std::atomic<uint64_t> DroppedEvents = 0;
+
+            // capture
+            std::mutex CaptureMutex;
+            ATraceWriter Writer;
+            std::atomic<bool> Capturing = false;
+
+            std::mutex CountersMutex;
+            std::map<std::string, double> Counters;
+
+            struct AInstantEvent
+            {
+                std::string Name;
+                uint64_t Time = 0;
+                std::vector<std::pair<std::string, double>> Args;
+            };
+
+            // written by the next Collect, guarded by CountersMutex too
+            std::vector<AInstantEvent> InstantEvents;
+
+            // the descriptors point at their key
+            std::mutex NamedZonesMutex;
+            std::map<std::string, AProfileZoneDesc> NamedZones;
+        };
+
+        AProfilerState &GetProfilerState()
+        {
+            static AProfilerState state;
+            return state;
+        }
+
+        thread_local AProfileThreadBuffer *ThreadBuffer = nullptr;
+
+        void PublishFrame(AProfilerState &state, AProfileThreadFrame &frame)
+        {
+            std::lock_guard lock(state.FramesMutex);
+
+            if (state.LastFrames.size() <= frame.ThreadIndex)
+            {
+                state.LastFrames.resize(frame.ThreadIndex + 1);
+            }
+
+            state.LastFrames[frame.ThreadIndex] = frame;
+        }
+    }
+
+    AProfileThreadBuffer *AProfiler::GetThreadBuffer()
+    {
+        if (ThreadBuffer != nullptr)
+        {
+            return ThreadBuffer;
+        }
+
+        AProfilerState &state = GetProfilerState();
+        std::lock_guard lock(state.BuffersMutex);
+
+        // buffers are never freed, threads from the OpenMP pool stick around anyway
+        auto buffer = std::make_unique<AProfileThreadBuffer>();
+        buffer->ThreadIndex = state.Buffers.size();
+        buffer->ThreadName = fmt::format("Thread {}", buffer->ThreadIndex);
+
+        ThreadBuffer = buffer.get();
+        state.Buffers.push_back(std::move(buffer));
+        AMemoryTracker::Allocate(EMemoryTag::Profiler, sizeof(AProfileThreadBuffer));
+
+        return ThreadBuffer;
+    }
+
+    void AProfiler::SetThreadName(const std::string &name)
+    {
+        AProfileThreadBuffer *buffer = GetThreadBuffer();
+
+        AProfilerState &state = GetProfilerState();
+        std::lock_guard lock(state.BuffersMutex);
+        buffer->ThreadName = name;
+    }
+
+    void AProfiler::MarkFrame()
+    {
+        GetThreadBuffer()->Push(nullptr, EProfileEventType::Frame);
+    }
+
+    uint64_t AProfiler::TicksToNs(uint64_t ticks)
+    {
+        AProfilerState &state = GetProfilerState();
+
+        if (ticks < state.StartTicks)
+        {
+            return 0;
+        }
+
+        return (uint64_t)((ticks - state.StartTicks) * state.NsPerTick.load(std::memory_order_relaxed));
+    }
+
+    uint64_t AProfiler::GetDroppedEventCount()
+    {
+        return GetProfilerState().DroppedEvents.load(std::memory_order_relaxed);
+    }
+
+    bool AProfiler::BeginCapture(const std::string &path)
+    {
+        AProfilerState &state = GetProfilerState();
+        std::lock_guard lock(state.CaptureMutex);
+
+        if (!state.Writer.Open(path))
+        {
+            std::cout << "AProfiler::BeginCapture | Error: Can't open " << path << std::endl;
+            return false;
+        }
+
+        std::cout << "Capturing profile to " << path << std::endl;
+        state.Capturing = true;
+
+        return true;
+    }
+
+    void AProfiler::EndCapture()
+    {
+        AProfilerState &state = GetProfilerState();
+        std::lock_guard lock(state.CaptureMutex);
+
+        if (!state.Capturing)
+        {
+            return;
+        }
+
+        state.Capturing = false;
+        state.Writer.Close();
+
+        std::cout << "Profile capture written to " << state.Writer.GetPath() << std::endl;
+    }
+
+    bool AProfiler::IsCapturing()
+    {
+        return GetProfilerState().Capturing.load(std::memory_order_relaxed);
+    }
+
+    void AProfiler::ToggleCapture()
+    {
+        if (IsCapturing())
+        {
+            EndCapture();
+            return;
+        }
+
+        auto now = std::chrono::system_clock::now().time_since_epoch();
+        BeginCapture(fmt::format("trace_{}.json", std::chrono::duration_cast<std::chrono::seconds>(now).count()));
+    }
+
+    void AProfiler::SetCounter(const std::string &name, double value)
+    {
+        AProfilerState &state = GetProfilerState();
+
+        if (!state.Capturing.load(std::memory_order_relaxed))
+        {
+            return;
+        }
+
+        std::lock_guard lock(state.CountersMutex);
+        state.Counters[name] = value;
+    }
+
+    void AProfiler::AddInstantEvent(const std::string &name, const std::vector<std::pair<std::string, double>> &args)
+    {
+        AProfilerState &state = GetProfilerState();
+
+        if (!state.Capturing.load(std::memory_order_relaxed))
+        {
+            return;
+        }
+
+        uint64_t now = TicksToNs(GetProfilerTicks());
+
+        std::lock_guard lock(state.CountersMutex);
+        state.InstantEvents.push_back({name, now, args});
+    }
+
+    const AProfileZoneDesc *AProfiler::GetNamedZone(const std::string &name)
+    {
+        // cycle through a few colors so neighbouring zones are easy to tell apart
+        static const Color colors[] = {DARKBLUE, DARKGREEN, DARKPURPLE, BROWN, MAROON, DARKGRAY};
+
+        AProfilerState &state = GetProfilerState();
+        std::lock_guard lock(state.NamedZonesMutex);
+
+        auto [it, inserted] = state.NamedZones.try_emplace(name);
+        if (inserted)
+        {
+            it->second.Name = it->first.c_str();
+            it->second.Col = colors[(state.NamedZones.size() - 1) % (sizeof(colors) / sizeof(Color))];
+        }
+
+        return &it->second;
+    }
+
+    void AProfiler::Collect()
+    {
+        AProfilerState &state = GetProfilerState();
+
+        std::unique_lock captureLock(state.CaptureMutex);
+        bool capturing = state.Capturing;
+        if (!capturing)
+        {
+            captureLock.unlock();
+        }
+
+        // refine the tick rate, gets more precise the longer we run
+        uint64_t elapsedTicks = GetProfilerTicks() - state.StartTicks;
+        auto elapsedTime = std::chrono::steady_clock::now() - state.StartTime;
+        double elapsedNs = std::chrono::duration<double, std::nano>(elapsedTime).count();
+        if (elapsedTicks > 0 && elapsedNs > 1000000.0)
+        {
+            state.NsPerTick.store(elapsedNs / elapsedTicks, std::memory_order_relaxed);
+        }
+
+        std::vector<AProfileThreadBuffer *> buffers;
+        std::vector<std::string> threadNames;
+        {
+            std::lock_guard lock(state.BuffersMutex);
+            for (auto &buffer : state.Buffers)
+            {
+                buffers.push_back(buffer.get());
+                threadNames.push_back(buffer->ThreadName);
+            }
+        }
+
+        if (state.CurrentFrames.size() < buffers.size())
+        {
+            state.CurrentFrames.resize(buffers.size());
+        }
+
+        std::vector<AProfileEvent> events;
+        for (size_t b = 0; b < buffers.size(); b++)
+        {
+            AProfileThreadBuffer *buffer = buffers[b];
+            AProfileThreadFrame &frame = state.CurrentFrames[b];
+            frame.ThreadIndex = buffer->ThreadIndex;
+            frame.ThreadName = threadNames[b];
+
+            uint64_t start = buffer->ReadIndex;
+            uint64_t end = buffer->WriteIndex.load(std::memory_order_acquire);
+
+            if (end - start > ATLANTIS_PROFILER_BUFFER_SIZE)
+            {
+                state.DroppedEvents.fetch_add(end - start - ATLANTIS_PROFILER_BUFFER_SIZE, std::memory_order_relaxed);
+                start = end - ATLANTIS_PROFILER_BUFFER_SIZE;
+                buffer->OpenZones.clear();
+            }
+
+            events.clear();
+            for (uint64_t i = start; i < end; i++)
+            {
+                events.push_back(buffer->Events[i & (ATLANTIS_PROFILER_BUFFER_SIZE - 1)]);
+            }
+
+            // the producer might have lapped us while we were copying
+            size_t firstValid = 0;
+            uint64_t written = buffer->WriteIndex.load(std::memory_order_acquire);
+            if (written - start > ATLANTIS_PROFILER_BUFFER_SIZE)
+            {
+                firstValid = std::min<size_t>(written - ATLANTIS_PROFILER_BUFFER_SIZE - start, events.size());
+                state.DroppedEvents.fetch_add(firstValid, std::memory_order_relaxed);
+                buffer->OpenZones.clear();
+            }
+
+            buffer->ReadIndex = end;
+
+            for (size_t i = firstValid; i < events.size(); i++)
+            {
+                const AProfileEvent &event = events[i];
+
+                switch (event.Type)
+                {
+                    case EProfileEventType::Begin:
+                        buffer->OpenZones.push_back(event);
+                        break;
+                    case EProfileEventType::End:
+                        if (!buffer->OpenZones.empty())
+                        {
+                            AProfileEvent begin = buffer->OpenZones.back();
+                            buffer->OpenZones.pop_back();
+
+                            frame.Zones.push_back({event.Zone,
+                                                   TicksToNs(begin.Ticks),
+                                                   TicksToNs(event.Ticks),
+                                                   (uint32_t)buffer->OpenZones.size()});
+
+                            if (capturing)
+                            {
+                                state.Writer.WriteZone(frame.ThreadIndex, frame.ThreadName, frame.Zones.back());
+                            }
+                        }
+                        break;
+                    case EProfileEventType::Frame:
+                    {
+                        uint64_t now = TicksToNs(event.Ticks);
+                        if (capturing)
+                        {
+                            state.Writer.WriteFrame(frame.ThreadIndex, frame.ThreadName, now);
+                        }
+
+                        if (buffer->HasFrames)
+                        {
+                            frame.End = now;
+                            PublishFrame(state, frame);
+                        }
+
+                        buffer->HasFrames = true;
+                        frame.Start = now;
+                        frame.Zones.clear();
+                        break;
+                    }
+                }
+            }
+
+            // threads without frame markers (e.g. OpenMP workers) publish whatever we got
+            if (!buffer->HasFrames && !frame.Zones.empty())
+            {
+                frame.Start = frame.Zones[0].Start;
+                frame.End = frame.Zones[0].End;
+                for (const AProfileZone &zone : frame.Zones)
+                {
+                    frame.Start = std::min(frame.Start, zone.Start);
+                    frame.End = std::max(frame.End, zone.End);
+                }
+
+                PublishFrame(state, frame);
+                frame.Zones.clear();
+            }
+        }
+
+        if (capturing)
+        {
+            uint64_t now = TicksToNs(GetProfilerTicks());
+
+            std::lock_guard lock(state.CountersMutex);
+            for (const auto &[name, value] : state.Counters)
+            {
+                state.Writer.WriteCounter(name, now, value);
+            }
+
+            for (const auto &event : state.InstantEvents)
+            {
+                state.Writer.WriteInstant(event.Name, event.Time, event.Args);
+            }
+
+            state.InstantEvents.clear();
+
+            state.Writer.Flush();
+        }
+    }
+
+    std::vector<AProfileThreadFrame> AProfiler::GetLastFrames()
+    {
+        AProfilerState &state = GetProfilerState();
+        std::lock_guard lock(state.FramesMutex);
+
+        std::vector<AProfileThreadFrame> frames;
+        for (const AProfileThreadFrame &frame : state.LastFrames)
+        {
+            if (frame.End > frame.Start)
+            {
+                frames.push_back(frame);
+            }
+        }
+
+        return frames;
+    }
+
+    // memory per tag, then pool usage per registered type
+    static void DrawMemoryStats(AWorld *world, int y, Color bg)
+    {
+        const int rowHeight = 20;
+        const int fontSize = 10;
+        const int nameWidth = 120;
+        const int columnWidth = 70;
+        const float mb = 1024.0f * 1024.0f;
+
+        const char *tagColumns[] = {"live MB", "peak MB", "allocs/frame", "KB/frame"};
+
+        y += 10;
+        DrawRectangle(0, y, nameWidth + columnWidth * 4 + 10, ((int)EMemoryTag::Count + 1) * rowHeight, bg);
+        DrawText("Memory", 10, y + 5, fontSize, LIGHTGRAY);
+        for (int i = 0; i < 4; i++)
+        {
+            DrawText(tagColumns[i], nameWidth + columnWidth * i, y + 5, fontSize, LIGHTGRAY);
+        }
+        y += rowHeight;
+
+        for (size_t i = 0; i < (size_t)EMemoryTag::Count; i++)
+        {
+            EMemoryTag tag = (EMemoryTag)i;
+            AMemoryTagStats stats = AMemoryTracker::GetStats(tag);
+
+            std::string values[] = {
+                fmt::format("{:.2f}", stats.LiveBytes / mb),
+                fmt::format("{:.2f}", stats.PeakBytes / mb),
+                fmt::format("{}", stats.FrameAllocations),
+                fmt::format("{:.1f}", stats.FrameBytes / 1024.0f)};
+
+            DrawText(AMemoryTracker::GetTagName(tag), 10, y + 5, fontSize, LIGHTGRAY);
+            for (int c = 0; c < 4; c++)
+            {
+                DrawText(values[c].c_str(), nameWidth + columnWidth * c, y + 5, fontSize, LIGHTGRAY);
+            }
+            y += rowHeight;
+        }
+
+        const char *poolColumns[] = {"used", "capacity", "dead", "frag", "reserved MB", "lists KB"};
+        const std::vector<APoolStats> &pools = world->PoolStatsSnapshot;
+
+        y += 10;
+        DrawRectangle(0, y, nameWidth + columnWidth * 6 + 10, (pools.size() + 1) * rowHeight, bg);
+        DrawText("Pool", 10, y + 5, fontSize, LIGHTGRAY);
+        for (int i = 0; i < 6; i++)
+        {
+            DrawText(poolColumns[i], nameWidth + columnWidth * i, y + 5, fontSize, LIGHTGRAY);
+        }
+        y += rowHeight;
+
+        for (const APoolStats &pool : pools)
+        {
+            std::string values[] = {
+                fmt::format("{}", pool.Used),
+                fmt::format("{}", pool.Capacity),
+                fmt::format("{}", pool.Dead),
+                fmt::format("{:.0f}%", pool.Fragmentation * 100.0f),
+                fmt::format("{:.2f}", pool.ReservedBytes / mb),
+                fmt::format("{:.1f}", pool.BookkeepingBytes / 1024.0f)};
+
+            DrawText(pool.Name.c_str(), 10, y + 5, fontSize, LIGHTGRAY);
+            for (int c = 0; c < 6; c++)
+            {
+                DrawText(values[c].c_str(), nameWidth + columnWidth * c, y + 5, fontSize, LIGHTGRAY);
+            }
+            y += rowHeight;
+        }
+    }
+
     void SSimpleProfiler::Process(AWorld *world)
     {
         if (_world == nullptr)
@@ -18,7 +479,18 @@ namespace Atlantis
             return;
         }
 
-        _world->ProfilingMutex.lock();
+        // input is polled on the render thread
+        if (IsKeyPressed(KEY_F9))
+        {
+            AProfiler::ToggleCapture();
+        }
+
+        // F8 switches the table below the timeline between systems and memory
+        static bool showMemory = false;
+        if (IsKeyPressed(KEY_F8))
+        {
+            showMemory = !showMemory;
+        }
 
         static float fps = 0.0f;
 
@@ -56,143 +528,115 @@ namespace Atlantis
         auto entityStr = fmt::format("Entities: {}", count);
         textSize = std::max(textSize, MeasureText(entityStr.c_str(), fontSize));
 
+        AResourceStats resourceStats = world->ResourceHolder.GetStats();
+        auto resourceStr = fmt::format("Textures: {} ({:.2f}/{:.0f} MB) Evictions: {} Reloads: {}",
+                                       resourceStats.ResidentCount,
+                                       resourceStats.ResidentBytes / (1024.0f * 1024.0f),
+                                       resourceStats.MemoryBudget / (1024.0f * 1024.0f),
+                                       resourceStats.Evictions,
+                                       resourceStats.Reloads);
+        textSize = std::max(textSize, MeasureText(resourceStr.c_str(), fontSize));
+
         Color bg = DARKGRAY;
         bg.a = 150;
 
-        float totalDuration = 0.0f;
-        for (auto &profileData : debugProfileData)
-        {
-            totalDuration += profileData.time;
-        }
+        // draw a timeline of the last frame of every thread, nested zones go below their parents
+        const int rowHeight = 20;
+        const int zoneFontSize = 10;
+        int screenWidth = GetScreenWidth();
+        int y = 0;
 
-        // draw the profile info
-        int x = 0;
-        int offset_tmp = 0;
-        for (auto &profileData : debugProfileData)
+        for (const AProfileThreadFrame &frame : AProfiler::GetLastFrames())
         {
-            int y = profileData.offset;
-            float duration = profileData.time;
-            float percent = duration / totalDuration;
-            int width = (int)(percent * GetScreenWidth());
-            DrawRectangle(x, y, width, 40, profileData.color);
-            auto profileStr = fmt::format("{}: {:.2f}ms", profileData.name, profileData.time * 1000.0f);
-            DrawText(profileStr.c_str(), x + 10, y + 10, 20, LIGHTGRAY);
-            DrawRectangle(x + width - 2, y, 2, 40, BLACK);
-            x += width;
-            offset_tmp = std::max(offset_tmp, profileData.offset);
-        }
+            if (frame.Zones.empty())
+            {
+                continue;
+            }
 
-        x = 0;
-        offset_tmp += 40;
+            float frameMs = (frame.End - frame.Start) / 1000000.0f;
+            auto threadStr = fmt::format("{}: {:.2f}ms", frame.ThreadName, frameMs);
+            DrawRectangle(0, y, screenWidth, rowHeight, bg);
+            DrawText(threadStr.c_str(), 10, y + 5, zoneFontSize, LIGHTGRAY);
+            y += rowHeight;
 
-        totalDuration = 0.0f;
-        for (auto &profileData : world->ProfilerMainThread->debugProfileData)
-        {
-            totalDuration += profileData.time;
-        }
+            double scale = (double)screenWidth / (double)(frame.End - frame.Start);
+            uint32_t maxDepth = 0;
 
-        for (auto& profileData : world->ProfilerMainThread->debugProfileData)
-        {
-            int y = offset_tmp + profileData.offset;
-            float duration = profileData.time;
-            float percent = duration / totalDuration;
-            int width = (int)(percent * GetScreenWidth());
-            DrawRectangle(x, y, width, 40, profileData.color);
-            auto profileStr = fmt::format("{}: {:.2f}ms", profileData.name, profileData.time * 1000.0f);
-            DrawText(profileStr.c_str(), x + 10, y + 10, 20, LIGHTGRAY);
-            DrawRectangle(x + width - 2, y, 2, 40, BLACK);
-            x += width;
-            offset_tmp = std::max(offset_tmp, profileData.offset);
-        }
+            for (const AProfileZone &zone : frame.Zones)
+            {
+                uint64_t zoneStart = std::max(zone.Start, frame.Start);
+                int x = (int)((zoneStart - frame.Start) * scale);
+                int width = std::max(1, (int)((zone.End - zoneStart) * scale));
+                int zoneY = y + zone.Depth * rowHeight;
 
-        debugProfileData.clear();
-        world->ProfilerMainThread->debugProfileData.clear();
+                DrawRectangle(x, zoneY, width, rowHeight, zone.Zone->Col);
 
-        DrawRectangle(0, offset_tmp + 40, textSize + 30, fontSize * 2 + 30, bg);
-        DrawText(fpsStr.c_str(), 10, offset_tmp + 40 + 10, fontSize, LIGHTGRAY);
-        DrawText(entityStr.c_str(), 10, offset_tmp + 40 + 30, fontSize, LIGHTGRAY);
+                auto profileStr = fmt::format("{}: {:.2f}ms", zone.Zone->Name, (zone.End - zone.Start) / 1000000.0f);
+                if (MeasureText(profileStr.c_str(), zoneFontSize) + 10 < width)
+                {
+                    DrawText(profileStr.c_str(), x + 5, zoneY + 5, zoneFontSize, LIGHTGRAY);
+                }
 
-        _world->ProfilingMutex.unlock();
-    }
+                DrawRectangle(x + width - 1, zoneY, 1, rowHeight, BLACK);
+                maxDepth = std::max(maxDepth, zone.Depth);
+            }
 
-    void SSimpleProfiler::AddProfileData(ADebugProfileData profileData)
-    {
-        if (_world == nullptr)
-        {
-            return;
+            y += (maxDepth + 1) * rowHeight;
         }
 
-        debugProfileData.push_back(profileData);
-    }
-
-    void SSimpleProfiler::SetOffset(float offset)
-    {
-        Offset = offset;
-        MaxOffset = std::max(MaxOffset, offset);
-    }
-
-    float SSimpleProfiler::GetOffset() const
-    {
-        return Offset;
-    }
+        DrawRectangle(0, y, textSize + 30, fontSize * 3 + 30, bg);
+        DrawText(fpsStr.c_str(), 10, y + 10, fontSize, LIGHTGRAY);
+        DrawText(entityStr.c_str(), 10, y + 30, fontSize, LIGHTGRAY);
+        DrawText(resourceStr.c_str(), 10, y + 50, fontSize, LIGHTGRAY);
 
-    ADebugProfileHelper::ADebugProfileHelper(std::string name, Color col, SSimpleProfiler *profiler)
-    {
-        this->profiler = profiler;
-        this->name = name;
-        this->color = col;
-        this->start = std::chrono::high_resolution_clock::now();
+        y += fontSize * 3 + 30;
 
-        if (profiler == nullptr)
+        if (AProfiler::IsCapturing())
         {
-            return;
+            DrawText("Capturing profile (F9 to stop)", 10, y + 10, fontSize, RED);
+            y += fontSize + 10;
         }
 
-        if (profiler->_world == nullptr)
+        if (showMemory)
         {
+            DrawMemoryStats(world, y, bg);
             return;
         }
 
-        profiler->_world->ProfilingMutex.lock();
-
-        offset = profiler->GetOffset();
-
-        auto it = std::find_if(profiler->debugProfileData.begin(), profiler->debugProfileData.end(), [name](const ADebugProfileData &data)
-                               { return data.name == name; });
-        if (it == profiler->debugProfileData.end())
-        {
-            profiler->SetOffset(profiler->GetOffset() + 40);
-        }
-    }
-
-    ADebugProfileHelper::~ADebugProfileHelper()
-    {
-        if (profiler == nullptr)
-        {
-            return;
-        }
+        // per system timings, in ms
+        const char *columns[] = {"last", "avg", "min", "p99", "entities", "slice"};
+        const int nameWidth = 200;
+        const int columnWidth = 60;
+        auto systemStats = world->GetSystemStats();
 
-        if (profiler->_world == nullptr)
+        y += 10;
+        DrawRectangle(0, y, nameWidth + columnWidth * 6 + 10, (systemStats.size() + 1) * rowHeight, bg);
+        DrawText("System", 10, y + 5, zoneFontSize, LIGHTGRAY);
+        for (int i = 0; i < 6; i++)
         {
-            return;
+            DrawText(columns[i], nameWidth + columnWidth * i, y + 5, zoneFontSize, LIGHTGRAY);
         }
+        y += rowHeight;
 
-        auto end = std::chrono::high_resolution_clock::now();
-        std::chrono::duration<float> duration = end - start;
-
-        auto it = std::find_if(profiler->debugProfileData.begin(), profiler->debugProfileData.end(), [this](const ADebugProfileData &data)
-                               { return data.name == name; });
-        if (it != profiler->debugProfileData.end())
-        {
-            it->time += duration.count();
-        }
-        else
+        for (const AWorld::ASystemStatsEntry &entry : systemStats)
         {
-            profiler->AddProfileData({name, duration.count(), color, offset});
-            profiler->SetOffset(profiler->GetOffset() - 40);
+            const ASystemStats &stats = entry.Stats;
+            std::string values[] = {
+                fmt::format("{:.3f}", stats.LastMs),
+                fmt::format("{:.3f}", stats.AvgMs),
+                fmt::format("{:.3f}", stats.MinMs),
+                fmt::format("{:.3f}", stats.P99Ms),
+                fmt::format("{}", stats.EntitiesProcessed),
+                entry.IsTimesliced ? fmt::format("{:.0f}%", stats.TimesliceProgress * 100.0f) : "-"};
+
+            auto nameStr = fmt::format("{}{}", entry.IsRenderSystem ? "[R] " : "", entry.Name);
+            DrawText(nameStr.c_str(), 10, y + 5, zoneFontSize, LIGHTGRAY);
+            for (int i = 0; i < 6; i++)
+            {
+                DrawText(values[i].c_str(), nameWidth + columnWidth * i, y + 5, zoneFontSize, LIGHTGRAY);
+            }
+            y += rowHeight;
         }
-
-        profiler->_world->ProfilingMutex.unlock();
     }
 
-} // namespace Atlantis
\ No newline at end of file
+} // namespace Atlantis
@@ -1,35 +1,170 @@
 #ifndef ATLANTIS_ENGINE_PROFILING_H
 #define ATLANTIS_ENGINE_PROFILING_H
 
+#include <array>
+#include <atomic>
 #include <chrono>
+#include <memory>
 #include <string>
 #include <vector>
 #include "engine/system.h"
 #include <mutex>
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#elif defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#endif
+
+// profiling is cheap enough to stay on, define as 0 to compile zones out
+#ifndef ATLANTIS_PROFILING
+#define ATLANTIS_PROFILING 1
+#endif
+
+// events per thread, has to be a power of two
+#define ATLANTIS_PROFILER_BUFFER_SIZE (1 << 14)
+
 namespace Atlantis
 {
-    struct ADebugProfileData
+    // one per call site or named zone, never freed so events only carry a pointer
+    struct AProfileZoneDesc
     {
-        std::string name;
-        float time = -1.0f;
-        Color color = PURPLE;
-        int offset = 0;
+        const char *Name;
+        Color Col;
     };
 
-    struct SSimpleProfiler;
+    enum class EProfileEventType : uint8_t
+    {
+        Begin,
+        End,
+        Frame
+    };
 
-    struct ADebugProfileHelper
+    struct AProfileEvent
     {
-        SSimpleProfiler *profiler = nullptr;
-        std::string name;
-        Color color = RAYWHITE;
-        int offset = 0;
-        std::chrono::high_resolution_clock::time_point start;
+        const AProfileZoneDesc *Zone;
+        uint64_t Ticks;
+        EProfileEventType Type;
+    };
+
+    inline uint64_t GetProfilerTicks()
+    {
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+        return __rdtsc();
+#else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+#endif
+    }
+
+    // single producer (the owning thread), single consumer (AProfiler::Collect)
+    struct AProfileThreadBuffer
+    {
+        std::array<AProfileEvent, ATLANTIS_PROFILER_BUFFER_SIZE> Events;
+        std::atomic<uint64_t> WriteIndex = 0;
+
+        uint32_t ThreadIndex = 0;
+        std::string ThreadName;
 
-        ADebugProfileHelper(std::string name, Color col, SSimpleProfiler *profiler);
+        // consumer side state
+        uint64_t ReadIndex = 0;
+        std::vector<AProfileEvent> OpenZones;
+        bool HasFrames = false;
 
-        ~ADebugProfileHelper();
+        void Push(const AProfileZoneDesc *zone, EProfileEventType type)
+        {
+            uint64_t index = WriteIndex.load(std::memory_order_relaxed);
+
+            AProfileEvent &event = Events[index & (ATLANTIS_PROFILER_BUFFER_SIZE - 1)];
+            event.Zone = zone;
+            event.Ticks = GetProfilerTicks();
+            event.Type = type;
+
+            WriteIndex.store(index + 1, std::memory_order_release);
+        }
+    };
+
+    // a finished zone, times are in nanoseconds since the profiler started
+    struct AProfileZone
+    {
+        const AProfileZoneDesc *Zone = nullptr;
+        uint64_t Start = 0;
+        uint64_t End = 0;
+        uint32_t Depth = 0;
+    };
+
+    struct AProfileThreadFrame
+    {
+        uint32_t ThreadIndex = 0;
+        std::string ThreadName;
+        uint64_t Start = 0;
+        uint64_t End = 0;
+        std::vector<AProfileZone> Zones;
+    };
+
+    struct AProfiler
+    {
+        // cheap after the first call on a thread
+        static AProfileThreadBuffer *GetThreadBuffer();
+
+        static void SetThreadName(const std::string &name);
+
+        // marks the start of a new frame on the calling thread
+        static void MarkFrame();
+
+        // drains all thread buffers, only call from one thread (main)
+        static void Collect();
+
+        // last completed frame of every thread that has recorded anything
+        static std::vector<AProfileThreadFrame> GetLastFrames();
+
+        static uint64_t TicksToNs(uint64_t ticks);
+
+        // number of events lost because a buffer wrapped before being collected
+        static uint64_t GetDroppedEventCount();
+
+        // streams every collected zone, frame and counter to a Chrome trace file
+        // until EndCapture is called, can be called from any thread
+        static bool BeginCapture(const std::string &path);
+
+        static void EndCapture();
+
+        static bool IsCapturing();
+
+        // starts a capture with a timestamped file name, or ends the current one
+        static void ToggleCapture();
+
+        // counters are sampled once per Collect while capturing
+        static void SetCounter(const std::string &name, double value);
+
+        // an instant event with a few values attached, for things that change too
+        // much to get a counter each, only recorded while capturing
+        static void AddInstantEvent(const std::string &name, const std::vector<std::pair<std::string, double>> &args);
+
+        // a zone for a name only known at runtime, e.g. a system's labels
+        // zones are never freed and keep their own copy of the name, so buffered
+        // events stay valid after whoever asked for it is gone
+        // the first call for a name picks its color
+        static const AProfileZoneDesc *GetNamedZone(const std::string &name);
+    };
+
+    struct AProfileScope
+    {
+        AProfileThreadBuffer *Buffer;
+        const AProfileZoneDesc *Zone;
+
+        AProfileScope(const AProfileZoneDesc *zone)
+            : Buffer(AProfiler::GetThreadBuffer())
+            , Zone(zone)
+        {
+            Buffer->Push(Zone, EProfileEventType::Begin);
+        }
+
+        ~AProfileScope()
+        {
+            Buffer->Push(Zone, EProfileEventType::End);
+        }
     };
 
     struct AWorld;
@@ -38,23 +173,20 @@ namespace Atlantis
     {
         AWorld* _world = nullptr;
 
-        float Offset = 0.0f;
-        float MaxOffset = 0.0f;
-        std::vector<ADebugProfileData> debugProfileData;
-
         SSimpleProfiler() { Labels.insert("SimpleProfiler"); };
         virtual void Process(AWorld *world) override;
-
-        void AddProfileData(ADebugProfileData profileData);
-        void PopProfileData();
-
-        void SetOffset(float offset);
-        float GetOffset() const;
     };
 
+#define __PROFILE_CONCAT_HELPER(a, b) a##b
+#define __PROFILE_CONCAT(a, b) __PROFILE_CONCAT_HELPER(a, b)
 
+#if ATLANTIS_PROFILING
+#define DO_PROFILE(name, color)                                                                 \
+    static const Atlantis::AProfileZoneDesc __PROFILE_CONCAT(_profileZone, __LINE__){name, color}; \
+    Atlantis::AProfileScope __PROFILE_CONCAT(_profileScope, __LINE__)(&__PROFILE_CONCAT(_profileZone, __LINE__))
+#else
 #define DO_PROFILE(name, color) ;
-//#define DO_PROFILE(name, color) ADebugProfileHelper profileHelper##__LINE__(name, color, world->GetSystem<SSimpleProfiler>("SimpleProfiler"))
+#endif
 } // namespace Atlantis
 
-#endif // ATLANTIS_ENGINE_PROFILING_H
\ No newline at end of file
+#endif // ATLANTIS_ENGINE_PROFILING_H
@@ -1,16 +1,118 @@
+#include <algorithm>
 #include "engine/system.h"
 #include "engine/core.h"
 #include "reflectionHelpers.h"
 
-void *Atlantis::AResourceHandle::GetPtr()
+void *Atlantis::AResourceHandle::GetPtr() const
 {
-    if (Address == 0)
+    if (ResourceHolder == nullptr)
     {
-        if (ResourceHolder != nullptr && ResourcePath.IsValid())
+        return nullptr;
+    }
+
+    return ResourceHolder->GetResourcePtr(Id);
+}
+
+void Atlantis::AResourceHandle::AcquireRef() const
+{
+    if (IsValid())
+    {
+        ResourceHolder->AddRef(Id);
+    }
+}
+
+void Atlantis::AResourceHandle::ReleaseRef() const
+{
+    if (IsValid())
+    {
+        ResourceHolder->Release(Id);
+    }
+}
+
+void nlohmann::adl_serializer<Atlantis::AResourceHandle>::to_json(json &j, const Atlantis::AResourceHandle &handle)
+{
+    j = handle.IsValid() ? handle.ResourceHolder->GetResourcePath(handle.Id) : std::string();
+}
+
+Atlantis::EPropertyKind Atlantis::GetPropertyKind(const AName &type)
+{
+    // spellings as they come out of the header parser
+    static const std::pair<AName, EPropertyKind> kinds[] = {
+        {"bool", EPropertyKind::Bool},
+        {"int", EPropertyKind::Int},
+        {"float", EPropertyKind::Float},
+        {"double", EPropertyKind::Double},
+        {"Color", EPropertyKind::Color},
+        {"Texture2D", EPropertyKind::Texture2D},
+        {"std::string", EPropertyKind::String},
+        {"Atlantis::AName", EPropertyKind::Name},
+        {"Atlantis::AResourceHandle", EPropertyKind::ResourceHandle}};
+
+    for (const auto &[name, kind] : kinds)
+    {
+        if (name == type)
+        {
+            return kind;
+        }
+    }
+
+    return EPropertyKind::Unknown;
+}
+
+Atlantis::AClassData Atlantis::AClassData::FromTable(const char *name, size_t size, std::span<const APropertyInfo> properties,
+                                                     void (*luaRegister)(lua_State *L), int (*luaPush)(lua_State *L, AObject *object))
+{
+    AClassData classData;
+    classData.Name = name;
+    classData.Size = size;
+    classData.LuaRegister = luaRegister;
+    classData.LuaPush = luaPush;
+
+    classData.Properties.reserve(properties.size());
+    for (const APropertyInfo &info : properties)
+    {
+        classData.Properties.push_back({AName(info.Name, info.NameHash), AName(info.Type, info.TypeHash), info.Offset, info.Size, info.Kind});
+    }
+
+    classData.BuildPropertyIndex();
+
+    return classData;
+}
+
+void Atlantis::AClassData::BuildPropertyIndex()
+{
+    PropertyIndex.clear();
+    PropertyIndex.reserve(Properties.size());
+
+    for (size_t i = 0; i < Properties.size(); i++)
+    {
+        PropertyIndex.emplace_back(Properties[i].Name.Hash, (uint32_t)i);
+    }
+
+    std::sort(PropertyIndex.begin(), PropertyIndex.end());
+}
+
+int Atlantis::AClassData::FindPropertyIndex(const AName &name) const
+{
+    if (PropertyIndex.size() != Properties.size())
+    {
+        for (size_t i = 0; i < Properties.size(); i++)
         {
-            Address = (size_t)ResourceHolder->GetResourcePtr(ResourcePath.GetName());
+            if (Properties[i].Name == name)
+            {
+                return (int)i;
+            }
         }
+
+        return -1;
+    }
+
+    auto it = std::lower_bound(PropertyIndex.begin(), PropertyIndex.end(), name.Hash, [](const std::pair<size_t, uint32_t> &entry, size_t hash)
+                               { return entry.first < hash; });
+    if (it == PropertyIndex.end() || it->first != name.Hash)
+    {
+        return -1;
     }
 
-    return (void*)Address;
-}
\ No newline at end of file
+    return (int)it->second;
+}
@@ -4,6 +4,8 @@
 #include <vector>
 #include <functional>
 #include <map>
+#include <span>
+#include <string_view>
 #include "nlohmann/json.hpp"
 #include "raylib.h"
 
@@ -13,9 +15,25 @@
 
 #define DEF_PROPERTY()
 
+struct lua_State;
+
 namespace Atlantis
 {
-    class AResourceHolder;
+    struct AResourceHolder;
+    struct AObject;
+
+    // FNV-1a, constexpr so the generated property tables can carry their hashes
+    constexpr size_t HashName(std::string_view name)
+    {
+        uint64_t hash = 14695981039346656037ull;
+        for (char c : name)
+        {
+            hash ^= (uint8_t)c;
+            hash *= 1099511628211ull;
+        }
+
+        return (size_t)hash;
+    }
 
     struct AName
     {
@@ -36,7 +54,7 @@ namespace Atlantis
                 Name.push_back(0);
             }
 
-            Hash = std::hash<std::string>{}(name);
+            Hash = HashName(name);
         }
 
         AName(const char *name)
@@ -49,7 +67,17 @@ namespace Atlantis
                 Name.push_back(0);
             }
 
-            Hash = std::hash<std::string>{}(name);
+            Hash = HashName(name);
+        }
+
+        // for names whose hash is known already, e.g. from HashName at compile time
+        AName(const char *name, size_t hash)
+        {
+            std::string n = name;
+            Name = { n.begin(), n.end() };
+            Name.push_back(0);
+
+            Hash = hash;
         }
 
         AName(const AName &other)
@@ -132,60 +160,178 @@ namespace Atlantis
 
     struct AResourceHandle
     {
-        size_t Address = 0;
-        AName ResourcePath;
+        static constexpr uint32_t InvalidId = ~0u;
+
+        // slot in the resource holder's table, resolving is a single index
+        uint32_t Id = InvalidId;
         AResourceHolder* ResourceHolder = nullptr;
 
         AResourceHandle()
         {
         }
-        
-        AResourceHandle(AResourceHolder* resourceHolder, std::string path)
+
+        AResourceHandle(AResourceHolder* resourceHolder, uint32_t id)
         {
             ResourceHolder = resourceHolder;
-            ResourcePath = path;
+            Id = id;
+            AcquireRef();
         }
 
-        AResourceHandle(AResource* ptr)
+        AResourceHandle(const AResourceHandle& other)
         {
-            Address = (size_t)ptr;
+            Id = other.Id;
+            ResourceHolder = other.ResourceHolder;
+            AcquireRef();
         }
 
-        AResourceHandle(const AResourceHandle& other)
+        // NOTE: pooled components are never constructed or destructed, the world
+        // counts their handles itself, see AWorld::AcquireResourceRefs
+        ~AResourceHandle()
         {
-            Address = other.Address;
-            ResourcePath = other.ResourcePath;
-            ResourceHolder = other.ResourceHolder;
+            ReleaseRef();
         }
 
-        void* GetPtr();
+        void* GetPtr() const;
 
         template <typename T>
-        T *get()
+        T *get() const
         {
             return static_cast<T *>(GetPtr());
         }
 
+        bool IsValid() const
+        {
+            return ResourceHolder != nullptr && Id != InvalidId;
+        }
+
         bool operator==(const AResourceHandle& other) const
         {
-            return Address == other.Address;
+            return Id == other.Id && ResourceHolder == other.ResourceHolder;
         }
 
         void operator=(const AResourceHandle& other)
         {
-            Address = other.Address;
-            ResourcePath = other.ResourcePath;
+            if (this == &other)
+            {
+                return;
+            }
+
+            other.AcquireRef();
+            ReleaseRef();
+
+            Id = other.Id;
             ResourceHolder = other.ResourceHolder;
         }
+
+        // for a handle that got here by memcpy, it takes its own reference
+        void AcquireCopiedRef() const
+        {
+            AcquireRef();
+        }
+
+        // gives up the reference, the handle is invalid afterwards
+        void Reset()
+        {
+            ReleaseRef();
+            Id = InvalidId;
+            ResourceHolder = nullptr;
+        }
+
+    private:
+        void AcquireRef() const;
+        void ReleaseRef() const;
+    };
+
+    // property types we know how to (de)serialize without going through json
+    enum class EPropertyKind : uint8_t
+    {
+        Unknown,
+        Bool,
+        Int,
+        Float,
+        Double,
+        Color,
+        Texture2D,
+        String,
+        Name,
+        ResourceHandle
     };
 
-    NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(AResourceHandle, Address);
+    EPropertyKind GetPropertyKind(const AName &type);
+
+    // kinds that can be copied byte by byte
+    inline bool IsTriviallyCopyable(EPropertyKind kind)
+    {
+        return kind != EPropertyKind::Unknown && kind != EPropertyKind::String && kind != EPropertyKind::Name && kind != EPropertyKind::ResourceHandle;
+    }
 
     struct APropertyData
     {
         AName Name;
         AName Type;
         size_t Offset;
+        size_t Size = 0;
+
+        // filled in by the header parser, generated serializers switch on this
+        EPropertyKind Kind = EPropertyKind::Unknown;
+
+        EPropertyKind GetKind() const
+        {
+            return Kind != EPropertyKind::Unknown ? Kind : GetPropertyKind(Type);
+        }
+    };
+
+    // a property as the header parser emits it, tables of these are constexpr and
+    // live in read only data
+    struct APropertyInfo
+    {
+        const char *Name;
+        size_t NameHash;
+        const char *Type;
+        size_t TypeHash;
+        size_t Offset;
+        size_t Size;
+        EPropertyKind Kind;
+    };
+
+    struct AClassData;
+
+    // a property resolved once by name, getting and setting through it is an offset
+    // add instead of a lookup
+    // only valid for objects of the class it was resolved on, IsFor checks that, a
+    // hot reload of the class' lib makes it stale
+    struct APropertyHandle
+    {
+        static constexpr size_t InvalidOffset = ~(size_t)0;
+
+        size_t Offset = InvalidOffset;
+        size_t Size = 0;
+        EPropertyKind Kind = EPropertyKind::Unknown;
+
+        // the class it was resolved on
+        const AClassData *ClassData = nullptr;
+
+        bool IsValid() const
+        {
+            return Offset != InvalidOffset;
+        }
+
+        bool IsFor(const AClassData &classData) const
+        {
+            return ClassData == &classData;
+        }
+
+        template <typename T>
+        T *GetPtr(void *object) const
+        {
+            return reinterpret_cast<T *>((size_t)object + Offset);
+        }
+
+        template <typename T>
+        const T *GetPtr(const void *object) const
+        {
+            return reinterpret_cast<const T *>((size_t)object + Offset);
+        }
     };
 
     struct AMethodData
@@ -201,12 +347,53 @@ namespace Atlantis
         AName Name;
         std::vector<APropertyData> Properties;
         std::vector<AMethodData> Methods;
-        size_t Size;
+        size_t Size = 0;
+
+        // generated sol2 bindings, null for classes without DEF_CLASS
+        // registers the class as a usertype with its properties as members
+        void (*LuaRegister)(lua_State *L) = nullptr;
+        // pushes an object of the class as that usertype
+        int (*LuaPush)(lua_State *L, AObject *object) = nullptr;
+
+        // (name hash, index into Properties) sorted by hash, see BuildPropertyIndex
+        std::vector<std::pair<size_t, uint32_t>> PropertyIndex;
 
         bool IsValid()
         {
             return Name.IsValid();
         }
+
+        // has to be called again whenever Properties changes, lookups fall back to
+        // a linear search while the index is out of date
+        void BuildPropertyIndex();
+
+        // index into Properties, -1 if the class has no such property
+        int FindPropertyIndex(const AName &name) const;
+
+        const APropertyData *FindProperty(const AName &name) const
+        {
+            int index = FindPropertyIndex(name);
+            return index >= 0 ? &Properties[index] : nullptr;
+        }
+
+        // invalid if the class has no such property
+        APropertyHandle GetPropertyHandle(const AName &name) const
+        {
+            APropertyHandle handle;
+            if (const APropertyData *propData = FindProperty(name))
+            {
+                handle.Offset = propData->Offset;
+                handle.Size = propData->Size;
+                handle.Kind = propData->GetKind();
+                handle.ClassData = this;
+            }
+
+            return handle;
+        }
+
+        // class data of a DEF_CLASS class, built once from its generated table
+        static AClassData FromTable(const char *name, size_t size, std::span<const APropertyInfo> properties,
+                                    void (*luaRegister)(lua_State *L), int (*luaPush)(lua_State *L, AObject *object));
     };
 }
 
@@ -227,6 +414,14 @@ struct adl_serializer<Atlantis::AName>
         name = Atlantis::AName(s);
     }
 };
+
+// written by path, the holder and slot id only mean something in this run.
+// there is no from_json, loading needs a world, see AObject::Deserialize
+template <>
+struct adl_serializer<Atlantis::AResourceHandle>
+{
+    static void to_json(json &j, const Atlantis::AResourceHandle &handle);
+};
 NLOHMANN_JSON_NAMESPACE_END
 
 #endif
\ No newline at end of file
@@ -0,0 +1,303 @@
+#include "engine/resources/resourceHolder.h"
+#include "engine/core.h"
+#include "engine/memoryTracker.h"
+#include "helpers.h"
+#include <algorithm>
+#include <iostream>
+#include <mutex>
+
+namespace Atlantis
+{
+    AResourceHolder::AResourceHolder(AWorld *world)
+    {
+        World = world;
+        Slots = std::make_unique<AResourceSlot[]>(ATLANTIS_MAX_RESOURCES);
+    }
+
+    AResourceHolder::~AResourceHolder()
+    {
+        Clear();
+    }
+
+    AResourceHandle AResourceHolder::GetTexture(const std::string &path)
+    {
+        if (World == nullptr)
+        {
+            std::cout << "AResourceHolder::GetTexture | Error: World is null" << std::endl;
+            return AResourceHandle();
+        }
+
+        bool created = false;
+        uint32_t id = InternPath(path, created);
+
+        if (id == AResourceHandle::InvalidId)
+        {
+            return AResourceHandle();
+        }
+
+        if (created)
+        {
+            RequestLoad(id);
+        }
+
+        return AResourceHandle(this, id);
+    }
+
+    void AResourceHolder::ReloadResource(const std::string &path)
+    {
+        uint32_t id = AResourceHandle::InvalidId;
+
+        {
+            std::shared_lock lock(IdsMutex);
+
+            auto it = Ids.find(AName(path));
+            if (it == Ids.end())
+            {
+                // never requested, it'll be loaded fresh when it is
+                return;
+            }
+
+            id = it->second;
+        }
+
+        std::lock_guard lock(PendingLoadsMutex);
+        PendingReloads.push_back(id);
+    }
+
+    void AResourceHolder::AddRef(uint32_t id)
+    {
+        if (id >= SlotCount.load(std::memory_order_acquire))
+        {
+            return;
+        }
+
+        Slots[id].RefCount.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void AResourceHolder::Release(uint32_t id)
+    {
+        if (id >= SlotCount.load(std::memory_order_acquire))
+        {
+            return;
+        }
+
+        Slots[id].RefCount.fetch_sub(1, std::memory_order_acq_rel);
+    }
+
+    const std::string &AResourceHolder::GetResourcePath(uint32_t id) const
+    {
+        static const std::string empty;
+
+        if (id >= SlotCount.load(std::memory_order_acquire))
+        {
+            return empty;
+        }
+
+        return Slots[id].Path;
+    }
+
+    uint32_t AResourceHolder::GetResourceCount() const
+    {
+        return SlotCount.load(std::memory_order_acquire);
+    }
+
+    void AResourceHolder::SetMemoryBudget(size_t bytes)
+    {
+        MemoryBudget.store(bytes, std::memory_order_relaxed);
+    }
+
+    AResourceStats AResourceHolder::GetStats() const
+    {
+        AResourceStats stats;
+        stats.ResidentBytes = ResidentBytes.load(std::memory_order_relaxed);
+        stats.MemoryBudget = MemoryBudget.load(std::memory_order_relaxed);
+        stats.ResidentCount = ResidentCount.load(std::memory_order_relaxed);
+        stats.SlotCount = SlotCount.load(std::memory_order_relaxed);
+        stats.Evictions = Evictions.load(std::memory_order_relaxed);
+        stats.Reloads = Reloads.load(std::memory_order_relaxed);
+
+        return stats;
+    }
+
+    void AResourceHolder::Update()
+    {
+        std::vector<uint32_t> pendingLoads;
+        std::vector<uint32_t> pendingReloads;
+        {
+            std::lock_guard lock(PendingLoadsMutex);
+            pendingLoads.swap(PendingLoads);
+            pendingReloads.swap(PendingReloads);
+        }
+
+        for (uint32_t id : pendingLoads)
+        {
+            LoadTextureResource(id);
+        }
+
+        // evicted ones get the new file once they're used again
+        for (uint32_t id : pendingReloads)
+        {
+            if (Slots[id].Resource.load(std::memory_order_acquire) != nullptr)
+            {
+                EvictResource(id);
+                LoadTextureResource(id);
+            }
+        }
+
+        uint32_t frame = CurrentFrame.fetch_add(1, std::memory_order_relaxed);
+
+        size_t budget = MemoryBudget.load(std::memory_order_relaxed);
+        if (ResidentBytes.load(std::memory_order_relaxed) <= budget)
+        {
+            return;
+        }
+
+        // only unreferenced resources that weren't used this frame can go
+        std::vector<uint32_t> candidates;
+        uint32_t count = SlotCount.load(std::memory_order_acquire);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            const AResourceSlot &slot = Slots[i];
+
+            if (slot.Resource.load(std::memory_order_relaxed) != nullptr &&
+                slot.RefCount.load(std::memory_order_acquire) <= 0 &&
+                slot.LastUsedFrame.load(std::memory_order_relaxed) != frame)
+            {
+                candidates.push_back(i);
+            }
+        }
+
+        std::sort(candidates.begin(), candidates.end(), [this](uint32_t l, uint32_t r)
+                  { return Slots[l].LastUsedFrame.load(std::memory_order_relaxed) < Slots[r].LastUsedFrame.load(std::memory_order_relaxed); });
+
+        for (uint32_t id : candidates)
+        {
+            if (ResidentBytes.load(std::memory_order_relaxed) <= budget)
+            {
+                break;
+            }
+
+            EvictResource(id);
+            Evictions.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    void AResourceHolder::Clear()
+    {
+        uint32_t count = SlotCount.load(std::memory_order_acquire);
+
+        for (uint32_t i = 0; i < count; i++)
+        {
+            EvictResource(i);
+        }
+    }
+
+    uint32_t AResourceHolder::InternPath(const std::string &path, bool &created)
+    {
+        created = false;
+        AName name = path;
+
+        {
+            std::shared_lock lock(IdsMutex);
+
+            auto it = Ids.find(name);
+            if (it != Ids.end())
+            {
+                return it->second;
+            }
+        }
+
+        std::unique_lock lock(IdsMutex);
+
+        // someone might have interned the path while we were waiting for the lock
+        auto it = Ids.find(name);
+        if (it != Ids.end())
+        {
+            return it->second;
+        }
+
+        uint32_t id = SlotCount.load(std::memory_order_relaxed);
+        if (id >= ATLANTIS_MAX_RESOURCES)
+        {
+            std::cout << "AResourceHolder::InternPath | Error: Resource limit reached, can't load " << path << std::endl;
+            return AResourceHandle::InvalidId;
+        }
+
+        Slots[id].Path = path;
+        Ids.emplace(name, id);
+
+        // publish the slot to lock-free readers
+        SlotCount.store(id + 1, std::memory_order_release);
+        created = true;
+
+        return id;
+    }
+
+    void AResourceHolder::RequestLoad(uint32_t id)
+    {
+        AResourceSlot &slot = Slots[id];
+
+        if (slot.LoadPending.exchange(true, std::memory_order_acq_rel))
+        {
+            return;
+        }
+
+        // textures can only be uploaded from the render thread
+        // we use our own queue instead of QueueRenderThreadCall, as this can be
+        // hit while the main thread is holding the render thread mutex
+        if (World == nullptr || World->IsMainThread())
+        {
+            std::lock_guard lock(PendingLoadsMutex);
+            PendingLoads.push_back(id);
+        }
+        else
+        {
+            LoadTextureResource(id);
+        }
+    }
+
+    void AResourceHolder::LoadTextureResource(uint32_t id)
+    {
+        AResourceSlot &slot = Slots[id];
+
+        if (slot.Resource.load(std::memory_order_acquire) == nullptr)
+        {
+            std::string fullPath = Helpers::GetProjectDirectory().string() + slot.Path;
+            ATextureResource *texture = new ATextureResource(LoadTexture(fullPath.c_str()));
+
+            const Texture2D &tex = texture->Texture;
+            slot.Bytes = GetPixelDataSize(tex.width, tex.height, tex.format);
+
+            if (slot.LoadCount > 0)
+            {
+                Reloads.fetch_add(1, std::memory_order_relaxed);
+            }
+            slot.LoadCount++;
+
+            ResidentBytes.fetch_add(slot.Bytes, std::memory_order_relaxed);
+            ResidentCount.fetch_add(1, std::memory_order_relaxed);
+            AMemoryTracker::Allocate(EMemoryTag::Resources, slot.Bytes);
+
+            slot.Resource.store(texture, std::memory_order_release);
+        }
+
+        slot.LoadPending.store(false, std::memory_order_release);
+    }
+
+    void AResourceHolder::EvictResource(uint32_t id)
+    {
+        AResourceSlot &slot = Slots[id];
+
+        AResource *resource = slot.Resource.exchange(nullptr, std::memory_order_acq_rel);
+        if (resource == nullptr)
+        {
+            return;
+        }
+
+        ResidentBytes.fetch_sub(slot.Bytes, std::memory_order_relaxed);
+        ResidentCount.fetch_sub(1, std::memory_order_relaxed);
+        AMemoryTracker::Free(EMemoryTag::Resources, slot.Bytes);
+
+        delete resource;
+    }
+}
@@ -0,0 +1,151 @@
+#ifndef ATLANTIS_ENGINE_RESOURCEHOLDER_H
+#define ATLANTIS_ENGINE_RESOURCEHOLDER_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "engine/reflection/reflectionHelpers.h"
+
+// TODO: arbitrary number, slots are preallocated so handles never see them move
+#define ATLANTIS_MAX_RESOURCES 4096
+
+// unreferenced resources get evicted once we go over this
+#define ATLANTIS_DEFAULT_RESOURCE_BUDGET (256ull * 1024ull * 1024ull)
+
+namespace Atlantis
+{
+    struct AWorld;
+
+    struct AResourceSlot
+    {
+        // published with release semantics once the resource is loaded,
+        // readers only ever do an acquire load
+        std::atomic<AResource *> Resource = nullptr;
+
+        // number of live handles pointing to this slot
+        std::atomic<int32_t> RefCount = 0;
+
+        // holder frame the resource was last resolved in, used for LRU eviction
+        std::atomic<uint32_t> LastUsedFrame = 0;
+
+        // set while a (re)load is queued so we only request it once
+        std::atomic<bool> LoadPending = false;
+
+        // only touched by the render thread
+        size_t Bytes = 0;
+        uint32_t LoadCount = 0;
+
+        // only written while the slot is being created, before SlotCount
+        // makes it visible to readers
+        std::string Path;
+    };
+
+    struct AResourceStats
+    {
+        size_t ResidentBytes = 0;
+        size_t MemoryBudget = 0;
+        uint32_t ResidentCount = 0;
+        uint32_t SlotCount = 0;
+        uint32_t Evictions = 0;
+        uint32_t Reloads = 0;
+    };
+
+    struct AResourceHolder
+    {
+        AWorld *World = nullptr;
+
+        AResourceHolder(AWorld *world);
+
+        ~AResourceHolder();
+
+        AResourceHandle GetTexture(const std::string &path);
+
+        // loads the resource again on the next Update if it's loaded, for when its
+        // file changed, path is relative to the project like in GetTexture
+        // safe to call from any thread
+        void ReloadResource(const std::string &path);
+
+        // lock-free, safe to call from any thread
+        // evicted resources get reloaded on demand, returning null until then
+        AResource *GetResourcePtr(uint32_t id)
+        {
+            if (id >= SlotCount.load(std::memory_order_acquire))
+            {
+                return nullptr;
+            }
+
+            AResourceSlot &slot = Slots[id];
+
+            uint32_t frame = CurrentFrame.load(std::memory_order_relaxed);
+            if (slot.LastUsedFrame.load(std::memory_order_relaxed) != frame)
+            {
+                slot.LastUsedFrame.store(frame, std::memory_order_relaxed);
+            }
+
+            AResource *resource = slot.Resource.load(std::memory_order_acquire);
+            if (resource == nullptr)
+            {
+                RequestLoad(id);
+            }
+
+            return resource;
+        }
+
+        void AddRef(uint32_t id);
+
+        void Release(uint32_t id);
+
+        const std::string &GetResourcePath(uint32_t id) const;
+
+        uint32_t GetResourceCount() const;
+
+        void SetMemoryBudget(size_t bytes);
+
+        AResourceStats GetStats() const;
+
+        // loads pending resources, advances the LRU clock and evicts
+        // unreferenced resources while over budget
+        // has to be called from the render thread
+        void Update();
+
+        // frees all loaded resources, has to be called from the render thread
+        void Clear();
+
+    private:
+        // returns the slot id for the path, creating a new slot if needed
+        uint32_t InternPath(const std::string &path, bool &created);
+
+        void RequestLoad(uint32_t id);
+
+        void LoadTextureResource(uint32_t id);
+
+        void EvictResource(uint32_t id);
+
+        // interned path -> slot id, only touched when resolving paths
+        std::unordered_map<AName, uint32_t, ANameHashFunction> Ids;
+        mutable std::shared_mutex IdsMutex;
+
+        std::unique_ptr<AResourceSlot[]> Slots;
+        std::atomic<uint32_t> SlotCount = 0;
+
+        // loads requested from other threads, drained by Update
+        std::vector<uint32_t> PendingLoads;
+        std::vector<uint32_t> PendingReloads;
+        std::mutex PendingLoadsMutex;
+
+        std::atomic<uint32_t> CurrentFrame = 1;
+        std::atomic<size_t> MemoryBudget = ATLANTIS_DEFAULT_RESOURCE_BUDGET;
+
+        // stats
+        std::atomic<size_t> ResidentBytes = 0;
+        std::atomic<uint32_t> ResidentCount = 0;
+        std::atomic<uint32_t> Evictions = 0;
+        std::atomic<uint32_t> Reloads = 0;
+    };
+}
+
+#endif // ATLANTIS_ENGINE_RESOURCEHOLDER_H
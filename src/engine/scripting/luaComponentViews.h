@@ -0,0 +1,282 @@
+#ifndef LUACOMPONENTVIEWS_H
+#define LUACOMPONENTVIEWS_H
+#include <sol/sol.hpp>
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+#include "engine/core.h"
+#include "engine/reflection/reflectionHelpers.h"
+
+namespace Atlantis
+{
+    // LuaJIT ffi structs generated from AClassData, so scripts can read and write
+    // component memory directly instead of going through userdata metamethods
+    //
+    // every component type gets a struct with its bool, int, float, double and color
+    // properties at their offsets, everything else is padding
+    // LuaJIT can't redefine a struct, a type whose layout changed on hot reload gets
+    // a new struct with a version suffix, views made before keep the old one
+    //
+    // views are raw pointers, they are only valid as long as the component is, debug
+    // builds check the generated layouts and that components are alive when a view
+    // is made, release builds don't check anything
+    struct ALuaComponentViews
+    {
+        // false without LuaJIT, there just won't be any views then
+        bool Init(sol::state &lua)
+        {
+            sol::protected_function_result result = lua.safe_script("return require('ffi')", sol::script_pass_on_error);
+            if (!result.valid())
+            {
+                std::cout << "ALuaComponentViews::Init | Error: ffi isn't available, no component views" << std::endl;
+                return false;
+            }
+
+            sol::table ffi = result.get<sol::table>();
+            Cdef = ffi["cdef"];
+            Cast = ffi["cast"];
+            TypeOf = ffi["typeof"];
+            SizeOf = ffi["sizeof"];
+            OffsetOf = ffi["offsetof"];
+
+            Available = true;
+            return true;
+        }
+
+        bool IsAvailable() const
+        {
+            return Available;
+        }
+
+        // declares the structs of all registered component types, types whose layout
+        // didn't change since the last call are skipped
+        void Register(AWorld *world)
+        {
+            if (!Available)
+            {
+                return;
+            }
+
+            for (const auto &[name, cdo] : world->CDOs)
+            {
+                if (dynamic_cast<AComponent *>(cdo.get()) == nullptr)
+                {
+                    continue;
+                }
+
+                RegisterType(cdo->GetClassData());
+            }
+        }
+
+        // the component as a pointer to its struct, nil if there is none
+        sol::object GetView(lua_State *L, AComponent *component)
+        {
+            if (!Available || component == nullptr)
+            {
+                return sol::make_object(L, sol::lua_nil);
+            }
+
+#ifndef NDEBUG
+            if (!component->_isAlive)
+            {
+                std::cout << "ALuaComponentViews::GetView | Error: " << component->GetClassData().Name.GetName() << " is dead" << std::endl;
+                return sol::make_object(L, sol::lua_nil);
+            }
+#endif
+
+            auto it = Types.find(component->GetClassData().Name);
+            if (it == Types.end() || !it->second.PointerType.valid())
+            {
+                return sol::make_object(L, sol::lua_nil);
+            }
+
+            return CastTo(it->second.PointerType, component);
+        }
+
+        // an array of component pointers as "struct X **", indexed from 0
+        sol::object GetArrayView(const AName &className, AComponent **components)
+        {
+            auto it = Types.find(className);
+            if (!Available || it == Types.end() || !it->second.ArrayType.valid())
+            {
+                return sol::object();
+            }
+
+            return CastTo(it->second.ArrayType, components);
+        }
+
+        // struct declaration for the layout of classData, named structName
+        static std::string MakeCdef(const AClassData &classData, const std::string &structName)
+        {
+            std::vector<const APropertyData *> properties;
+            for (const auto &propData : classData.Properties)
+            {
+                properties.push_back(&propData);
+            }
+
+            std::sort(properties.begin(), properties.end(), [](const APropertyData *a, const APropertyData *b)
+                      { return a->Offset < b->Offset; });
+
+            std::string cdef = "struct " + structName + " {\n";
+            size_t current = 0;
+            int padIndex = 0;
+
+            auto pad = [&](size_t to)
+            {
+                if (to > current)
+                {
+                    cdef += "    uint8_t _pad" + std::to_string(padIndex++) + "[" + std::to_string(to - current) + "];\n";
+                    current = to;
+                }
+            };
+
+            for (const APropertyData *propData : properties)
+            {
+                std::string type = GetCType(propData->GetKind(), propData->Size);
+                if (type.empty() || propData->Offset < current)
+                {
+                    continue;
+                }
+
+                pad(propData->Offset);
+                cdef += "    " + type + " " + propData->Name.GetName() + ";\n";
+                current += propData->Size;
+            }
+
+            pad(classData.Size);
+            cdef += "};";
+
+            return cdef;
+        }
+
+    private:
+        struct AViewType
+        {
+            // the declaration with the struct name left out, to see if the layout changed
+            std::string Layout;
+            std::string StructName;
+            int Version = 0;
+
+            sol::object PointerType;
+            sol::object ArrayType;
+        };
+
+        static std::string GetCType(EPropertyKind kind, size_t size)
+        {
+            switch (kind)
+            {
+            case EPropertyKind::Bool:
+                return size == sizeof(bool) ? "bool" : "";
+            case EPropertyKind::Int:
+                return size == sizeof(int32_t) ? "int32_t" : "";
+            case EPropertyKind::Float:
+                return size == sizeof(float) ? "float" : "";
+            case EPropertyKind::Double:
+                return size == sizeof(double) ? "double" : "";
+            case EPropertyKind::Color:
+                return size == 4 ? "struct { uint8_t r, g, b, a; }" : "";
+            default:
+                return "";
+            }
+        }
+
+        void RegisterType(const AClassData &classData)
+        {
+            std::string layout = MakeCdef(classData, "");
+
+            AViewType &viewType = Types[classData.Name];
+            if (viewType.Layout == layout)
+            {
+                return;
+            }
+
+            // a declared name can't be used again, even if the declaration failed
+            viewType.Layout = layout;
+            viewType.Version++;
+            viewType.StructName = classData.Name.GetName() + "_" + std::to_string(viewType.Version);
+            viewType.PointerType = sol::object();
+            viewType.ArrayType = sol::object();
+
+            std::string structName = viewType.StructName;
+            sol::protected_function_result result = Cdef(MakeCdef(classData, structName));
+            if (!result.valid())
+            {
+                sol::error error = result;
+                std::cout << "ALuaComponentViews::RegisterType | Error: " << classData.Name.GetName() << ": " << error.what() << std::endl;
+                return;
+            }
+
+#ifndef NDEBUG
+            if (!CheckLayout(classData, "struct " + structName))
+            {
+                return;
+            }
+#endif
+
+            viewType.PointerType = TypeOf("struct " + structName + " *");
+            viewType.ArrayType = TypeOf("struct " + structName + " **");
+        }
+
+        // the declared struct has to match the C++ layout, or views would write to the
+        // wrong memory
+        bool CheckLayout(const AClassData &classData, const std::string &type)
+        {
+            size_t size = SizeOf(type).get<size_t>();
+            if (size != classData.Size)
+            {
+                std::cout << "ALuaComponentViews::CheckLayout | Error: " << type << " is " << size << " bytes instead of " << classData.Size << std::endl;
+                return false;
+            }
+
+            for (const auto &propData : classData.Properties)
+            {
+                if (GetCType(propData.GetKind(), propData.Size).empty())
+                {
+                    continue;
+                }
+
+                sol::protected_function_result result = OffsetOf(type, propData.Name.GetName());
+                if (!result.valid() || result.get_type() != sol::type::number)
+                {
+                    continue;
+                }
+
+                size_t offset = result.get<size_t>();
+                if (offset != propData.Offset)
+                {
+                    std::cout << "ALuaComponentViews::CheckLayout | Error: " << type << "." << propData.Name.GetName() << " is at " << offset << " instead of " << propData.Offset << std::endl;
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        sol::object CastTo(const sol::object &type, void *ptr)
+        {
+            sol::protected_function_result result = Cast(type, ptr);
+            if (!result.valid())
+            {
+                sol::error error = result;
+                std::cout << "ALuaComponentViews::CastTo | Error: " << error.what() << std::endl;
+                return sol::object();
+            }
+
+            return result.get<sol::object>();
+        }
+
+        bool Available = false;
+
+        // keyed by class name
+        std::map<AName, AViewType, ANameComparer> Types;
+
+        sol::protected_function Cdef;
+        sol::protected_function Cast;
+        sol::protected_function TypeOf;
+        sol::protected_function SizeOf;
+        sol::protected_function OffsetOf;
+    };
+}
+#endif
@@ -0,0 +1,227 @@
+#ifndef LUAPROFILER_H
+#define LUAPROFILER_H
+#include <sol/sol.hpp>
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+#include "engine/profiling.h"
+
+namespace Atlantis
+{
+    // samples which script functions the lua systems spend their time in
+    //
+    // uses LuaJIT's jit.profile when it's there, which samples every IntervalMs
+    // including JIT compiled code, otherwise a count hook takes a sample every
+    // HookInstructions vm instructions
+    // samples go to the system that was running (its labels), and to "other" outside
+    // of systems, while a trace is being captured every system gets a counter with
+    // its samples per frame, and an instant event with its hottest locations
+    //
+    // off by default, it's cheap enough to turn on in production builds when needed
+    struct ALuaProfiler
+    {
+        int IntervalMs = 1;
+        int HookInstructions = 1000;
+
+        // locations per system written to the trace each frame
+        size_t TraceLocations = 3;
+
+        bool IsRunning() const
+        {
+            return Running;
+        }
+
+        void Start(sol::state &lua)
+        {
+            if (Running)
+            {
+                return;
+            }
+
+            L = lua.lua_state();
+
+            sol::protected_function_result result = lua.safe_script("return require('jit.profile')", sol::script_pass_on_error);
+            if (result.valid())
+            {
+                sol::table profile = result.get<sol::table>();
+
+                lua.set_function("__AtlantisProfilerSample", [this](const std::string &function, const std::string &line, int samples)
+                                 { AddSample(function + " (" + line + ")", samples); });
+
+                // dumpstack has to run inside the callback, the stack is gone afterwards
+                sol::protected_function_result callback = lua.safe_script(R"(
+                    local profile = require("jit.profile")
+                    local sample = __AtlantisProfilerSample
+                    return function(thread, samples, vmstate)
+                        sample(profile.dumpstack(thread, "F", 1), profile.dumpstack(thread, "l", 1), samples)
+                    end)",
+                                                                          sol::script_pass_on_error);
+
+                if (callback.valid())
+                {
+                    sol::protected_function start = profile["start"];
+                    start("i" + std::to_string(IntervalMs), callback.get<sol::function>());
+                    JitProfile = true;
+                    Running = true;
+                    return;
+                }
+            }
+
+            Active = this;
+            lua_sethook(L, &ALuaProfiler::Hook, LUA_MASKCOUNT, HookInstructions);
+            JitProfile = false;
+            Running = true;
+        }
+
+        void Stop(sol::state &lua)
+        {
+            if (!Running)
+            {
+                return;
+            }
+
+            if (JitProfile)
+            {
+                lua.safe_script("require('jit.profile').stop()", sol::script_pass_on_error);
+            }
+            else
+            {
+                lua_sethook(L, nullptr, 0, 0);
+                Active = nullptr;
+            }
+
+            Running = false;
+        }
+
+        // around every lua system call
+        void BeginSystem(const std::string *system)
+        {
+            CurrentSystem = system;
+        }
+
+        void EndSystem()
+        {
+            CurrentSystem = nullptr;
+        }
+
+        // once per frame, writes the frame's hottest locations to the trace
+        void EndFrame()
+        {
+            if (!Running)
+            {
+                return;
+            }
+
+            if (AProfiler::IsCapturing())
+            {
+                // locations come and go, they are event args so the set of counters
+                // stays one per system
+                for (const auto &[system, locations] : FrameSamples)
+                {
+                    uint64_t total = 0;
+                    for (const auto &[location, samples] : locations)
+                    {
+                        total += samples;
+                    }
+
+                    std::vector<std::pair<std::string, double>> args;
+                    for (const auto &[location, samples] : GetTop(locations, TraceLocations))
+                    {
+                        args.emplace_back(location, (double)samples);
+                    }
+
+                    AProfiler::SetCounter("Lua " + system, (double)total);
+
+                    if (!args.empty())
+                    {
+                        AProfiler::AddInstantEvent("Lua " + system, args);
+                    }
+                }
+            }
+
+            // systems that didn't run this frame report 0 instead of their last value
+            for (auto &[system, locations] : FrameSamples)
+            {
+                locations.clear();
+            }
+        }
+
+        // hottest locations per system since the profiler started or was cleared
+        void PrintReport(size_t top = 10) const
+        {
+            for (const auto &[system, locations] : Samples)
+            {
+                uint64_t total = 0;
+                for (const auto &[location, samples] : locations)
+                {
+                    total += samples;
+                }
+
+                std::cout << "Lua profile " << system << ", " << total << " samples" << std::endl;
+                for (const auto &[location, samples] : GetTop(locations, top))
+                {
+                    std::cout << "  " << samples * 100 / std::max<uint64_t>(total, 1) << "% " << samples << " " << location << std::endl;
+                }
+            }
+        }
+
+        void Clear()
+        {
+            Samples.clear();
+            FrameSamples.clear();
+        }
+
+    private:
+        void AddSample(const std::string &location, int samples)
+        {
+            const std::string &system = CurrentSystem != nullptr ? *CurrentSystem : OtherSystem;
+
+            Samples[system][location] += samples;
+            FrameSamples[system][location] += samples;
+        }
+
+        static std::vector<std::pair<std::string, uint64_t>> GetTop(const std::map<std::string, uint64_t> &locations, size_t count)
+        {
+            std::vector<std::pair<std::string, uint64_t>> top(locations.begin(), locations.end());
+            std::sort(top.begin(), top.end(), [](const auto &a, const auto &b)
+                      { return a.second > b.second; });
+
+            if (top.size() > count)
+            {
+                top.resize(count);
+            }
+
+            return top;
+        }
+
+        static void Hook(lua_State *L, lua_Debug *ar)
+        {
+            if (Active == nullptr || lua_getstack(L, 0, ar) == 0)
+            {
+                return;
+            }
+
+            lua_getinfo(L, "Sln", ar);
+
+            std::string function = ar->name != nullptr ? ar->name : "?";
+            Active->AddSample(function + " (" + ar->short_src + ":" + std::to_string(ar->currentline) + ")", 1);
+        }
+
+        // the hook is a plain function, only one state gets profiled at a time
+        static inline ALuaProfiler *Active = nullptr;
+
+        lua_State *L = nullptr;
+        bool Running = false;
+        bool JitProfile = false;
+
+        const std::string *CurrentSystem = nullptr;
+        const std::string OtherSystem = "other";
+
+        // system -> location -> samples
+        std::map<std::string, std::map<std::string, uint64_t>> Samples;
+        std::map<std::string, std::map<std::string, uint64_t>> FrameSamples;
+    };
+}
+#endif
@@ -1,91 +1,115 @@
 #ifndef LUARUNTIME_H
 #define LUARUNTIME_H
 #include <sol/sol.hpp>
+#include <chrono>
+#include <cstring>
 #include <iostream>
 #include <filesystem>
 #include <unordered_map>
 #include "engine/core.h"
+#include "engine/dynamicComponent.h"
+#include "engine/profiling.h"
 #include "engine/renderer/renderer.h"
+#include "engine/scripting/luaComponentViews.h"
+#include "engine/scripting/luaProfiler.h"
+#include "engine/scripting/luaWorkers.h"
 #include "engine/reflection/reflectionHelpers.h"
 
 namespace Atlantis
 {
-#define DECLARE_PROPERTY_TYPE(name) static const AName _propType_##name = #name;
-#define DECLARE_PROPERTY_TYPE_ATLANTIS(name) static const AName _propType_##name = "Atlantis::" #name;
-#define GET_PROPERTY_TYPE(name) _propType_##name
+    // GetProperty and SetProperty are overloaded for handles, these are the by name ones
+    template <typename T>
+    inline constexpr T (AObject::*GetPropertyByName)(const AName &) const = &AObject::GetProperty<T>;
 
-    DECLARE_PROPERTY_TYPE(int)
-    DECLARE_PROPERTY_TYPE(float)
-    DECLARE_PROPERTY_TYPE(bool)
-    DECLARE_PROPERTY_TYPE(string)
-    DECLARE_PROPERTY_TYPE_ATLANTIS(AResourceHandle)
+    template <typename T>
+    inline constexpr void (AObject::*SetPropertyByName)(const AName &, T) = &AObject::SetProperty<T>;
 
-#define SCRIPTING_EXPOSE_COMPONENT(name)                             \
-    sol::usertype<name> type_##name = Lua.new_usertype<name>(#name); \
-    entity_type["GetComponent_" #name] = &AEntity::GetComponentOfType<name>;
-
-    template <>
-    sol::object AComponent::GetPropertyScripting<sol::object, sol::stack_object, sol::this_state>(sol::stack_object key, sol::this_state L)
+    // reads a property of a kind lua knows about, nil for the rest
+    inline sol::object GetPropertyLua(sol::this_state L, EPropertyKind kind, void *val)
     {
-        auto maybe_string_key = key.as<sol::optional<std::string>>();
-        if (!maybe_string_key)
+        switch (kind)
         {
+        case EPropertyKind::Int:
+            return sol::make_object(L, *static_cast<int *>(val));
+        case EPropertyKind::Float:
+            return sol::make_object(L, *static_cast<float *>(val));
+        case EPropertyKind::Double:
+            return sol::make_object(L, *static_cast<double *>(val));
+        case EPropertyKind::Bool:
+            return sol::make_object(L, *static_cast<bool *>(val));
+        case EPropertyKind::String:
+            return sol::make_object(L, *static_cast<std::string *>(val));
+        case EPropertyKind::ResourceHandle:
+            return sol::make_object(L, *static_cast<AResourceHandle *>(val));
+        default:
             return sol::nil;
         }
+    }
 
-        static APropertyData propData;
-        static std::string tmpStr;
-        static std::unordered_map<std::string, APropertyData> memo;
-
-        tmpStr = *maybe_string_key;
-
-        auto it = memo.find(tmpStr);
-        if (it != memo.end())
+    inline void SetPropertyLua(EPropertyKind kind, void *val, const sol::stack_object &value)
+    {
+        switch (kind)
         {
-            propData = it->second;
-        }
-        else
-        {
-            const AClassData &classData = GetClassData();
-            for (const auto &property : classData.Properties)
-            {
-                if (property.Name == tmpStr)
-                {
-                    propData = property;
-                    break;
-                }
-            }
-
-            memo[tmpStr] = propData;
+        case EPropertyKind::Int:
+            *static_cast<int *>(val) = value.as<int>();
+            break;
+        case EPropertyKind::Float:
+            *static_cast<float *>(val) = value.as<float>();
+            break;
+        case EPropertyKind::Double:
+            *static_cast<double *>(val) = value.as<double>();
+            break;
+        case EPropertyKind::Bool:
+            *static_cast<bool *>(val) = value.as<bool>();
+            break;
+        case EPropertyKind::String:
+            *static_cast<std::string *>(val) = value.as<std::string>();
+            break;
+        case EPropertyKind::ResourceHandle:
+            *static_cast<AResourceHandle *>(val) = value.as<AResourceHandle>();
+            break;
+        default:
+            break;
         }
+    }
 
-        if (propData.Type == GET_PROPERTY_TYPE(int))
-        {
-            int *val = reinterpret_cast<int *>((size_t)this + propData.Offset);
-            return sol::make_object(L, *val);
-        }
-        else if (propData.Type == GET_PROPERTY_TYPE(float))
+    // handles from scripts can come from any class, using one on another class
+    // would read or write out of bounds
+    inline bool CheckPropertyHandle(const AComponent &component, const APropertyHandle &handle)
+    {
+        if (!handle.IsValid())
         {
-            float *val = reinterpret_cast<float *>((size_t)this + propData.Offset);
-            return sol::make_object(L, *val);
+            return false;
         }
-        else if (propData.Type == GET_PROPERTY_TYPE(bool))
+
+        if (!handle.IsFor(component.GetClassData()))
         {
-            bool *val = reinterpret_cast<bool *>((size_t)this + propData.Offset);
-            return sol::make_object(L, *val);
+            std::cout << "CheckPropertyHandle | Error: Handle of another class used on " << component.GetClassData().Name.GetName() << std::endl;
+            return false;
         }
-        else if (propData.Type == GET_PROPERTY_TYPE(string))
+
+        return true;
+    }
+
+    // components whose class got generated bindings (see AClassData::LuaRegister) are
+    // pushed as their own usertype with direct member access, these are the fallback
+    // for the rest
+    template <>
+    sol::object AComponent::GetPropertyScripting<sol::object, sol::stack_object, sol::this_state>(sol::stack_object key, sol::this_state L)
+    {
+        auto maybe_string_key = key.as<sol::optional<std::string>>();
+        if (!maybe_string_key)
         {
-            std::string *val = reinterpret_cast<std::string *>((size_t)this + propData.Offset);
-            return sol::make_object(L, *val);
+            return sol::nil;
         }
-        else if (propData.Type == GET_PROPERTY_TYPE(AResourceHandle))
+
+        const APropertyData *propData = GetClassData().FindProperty(*maybe_string_key);
+        if (propData == nullptr)
         {
-            AResourceHandle *val = reinterpret_cast<AResourceHandle *>((size_t)this + propData.Offset);
-            return sol::make_object(L, *val);
+            return sol::nil;
         }
 
-        return sol::nil;
+        return GetPropertyLua(L, propData->GetKind(), (void *)((size_t)this + propData->Offset));
     }
 
     template <>
@@ -97,46 +121,47 @@ namespace Atlantis
             return;
         }
 
-        AName k = *maybe_string_key;
-        const AClassData &classData = GetClassData();
-
-        for (const auto &property : classData.Properties)
+        const APropertyData *propData = GetClassData().FindProperty(*maybe_string_key);
+        if (propData == nullptr)
         {
-            if (property.Name == k)
-            {
-                if (property.Type == GET_PROPERTY_TYPE(int))
-                {
-                    SetProperty<int>(k, value.as<int>());
-                }
-                else if (property.Type == GET_PROPERTY_TYPE(float))
-                {
-                    SetProperty<float>(k, value.as<float>());
-                }
-                else if (property.Type == GET_PROPERTY_TYPE(bool))
-                {
-                    SetProperty<bool>(k, value.as<bool>());
-                }
-                else if (property.Type == GET_PROPERTY_TYPE(string))
-                {
-                    SetProperty<std::string>(k, value.as<std::string>());
-                }
-                else if (property.Type == GET_PROPERTY_TYPE(AResourceHandle))
-                {
-                    SetProperty<AResourceHandle>(k, value.as<AResourceHandle>());
-                }
-            }
+            return;
         }
+
+        SetPropertyLua(propData->GetKind(), (void *)((size_t)this + propData->Offset), value);
     }
 
-    struct CLuaComponent : public AComponent
+    // a component type declared by a script
+    struct ALuaComponentSchema
     {
-        sol::table LuaTable;
+        // CDynamicComponent objects point at it, so it stays where it is
+        std::unique_ptr<AClassData> ClassData;
+
+        // the CDO's property bytes, everything after the CDynamicComponent
+        std::vector<uint8_t> Defaults;
+    };
+
+    // a lua function registered as a system, reloading a script swaps Func in place
+    struct ALuaSystemBinding
+    {
+        sol::protected_function Func;
+
+        // the joined labels, what ALuaProfiler reports the system as
+        std::string Name;
     };
 
     struct ALuaWorld
     {
         AWorld *World = nullptr;
         sol::state *Lua = nullptr;
+        ALuaComponentViews *Views = nullptr;
+        ALuaWorkerPool *Workers = nullptr;
+        ALuaProfiler *Profiler = nullptr;
+
+        // where the worker states look for modules
+        std::filesystem::path ScriptDirectory;
+
+        // entities per call of ForEntitiesInChunks and ForEntityViewsInChunks
+        int ChunkSize = 1024;
 
         void SetState(sol::state *lua)
         {
@@ -148,29 +173,256 @@ namespace Atlantis
             World->RegisterDefault<AEntity>(name);
         }
 
-        void RegisterComponent(const std::string &name)
+        // fields is a list of { name, type, default } with an optional default, e.g.
+        //   RegisterComponent("CHealth", { { "health", "int", 100 }, { "regen", "float" } })
+        // the fields get native storage in the component pool (see CDynamicComponent),
+        // so they can be iterated, viewed through ffi and serialized like C++ ones
+        // registering it again after a script reload only updates the defaults, the
+        // fields can't change without a restart
+        void RegisterComponent(const std::string &name, sol::optional<sol::table> fields)
+        {
+            std::vector<CDynamicComponent::AField> schemaFields;
+            std::vector<sol::object> defaults;
+
+            if (fields)
+            {
+                for (size_t i = 1; i <= fields->size(); i++)
+                {
+                    sol::object field = (*fields)[i];
+                    sol::table fieldTable = field.is<sol::table>() ? field.as<sol::table>() : sol::table();
+                    if (!fieldTable.valid() || !fieldTable[1].is<std::string>() || !fieldTable[2].is<std::string>())
+                    {
+                        std::cout << "ALuaWorld::RegisterComponent | Error: Field " << i << " of " << name << " isn't { name, type, default }" << std::endl;
+                        return;
+                    }
+
+                    schemaFields.push_back({fieldTable[1].get<std::string>(), fieldTable[2].get<std::string>()});
+                    defaults.push_back(fieldTable[3]);
+                }
+            }
+
+            std::unique_ptr<AClassData> classData = std::make_unique<AClassData>();
+            if (!CDynamicComponent::MakeClassData(name, schemaFields, *classData))
+            {
+                return;
+            }
+
+            std::vector<uint8_t> defaultBytes(classData->Size - sizeof(CDynamicComponent), 0);
+            for (size_t i = 0; i < classData->Properties.size(); i++)
+            {
+                WriteDefault(classData->Properties[i], defaults[i], defaultBytes.data());
+            }
+
+            auto it = ComponentSchemas.find(name);
+            if (it != ComponentSchemas.end())
+            {
+                if (!IsSameSchema(*it->second.ClassData, *classData))
+                {
+                    std::cout << "ALuaWorld::RegisterComponent | Error: The fields of " << name << " changed, restart to use the new ones" << std::endl;
+                    return;
+                }
+
+                it->second.Defaults = defaultBytes;
+
+                auto cdo = World->CDOs.find(name);
+                if (cdo != World->CDOs.end() && !defaultBytes.empty())
+                {
+                    memcpy((uint8_t *)cdo->second.get() + sizeof(CDynamicComponent), defaultBytes.data(), defaultBytes.size());
+                }
+
+                return;
+            }
+
+            ALuaComponentSchema &schema = ComponentSchemas[name];
+            schema.ClassData = std::move(classData);
+            schema.Defaults = defaultBytes;
+
+            RegisterSchema(schema);
+
+            if (Views != nullptr)
+            {
+                Views->Register(World);
+            }
+
+            if (Workers != nullptr)
+            {
+                Workers->RegisterTypes(World);
+            }
+        }
+
+        // the world forgets types the new game lib doesn't register on hot reload,
+        // this registers the script's ones again, their pools stay as they are
+        void RegisterComponentSchemas()
         {
-            World->RegisterDefault<CLuaComponent>(name);
+            for (auto &[name, schema] : ComponentSchemas)
+            {
+                RegisterSchema(schema);
+            }
         }
 
-        void RegisterSystem(sol::function func, std::vector<AName> labels, std::vector<AName> beforeLabels)
+        // systems are identified by their labels, registering the same labels again
+        // after a script reload only swaps the function, systems without labels are
+        // identified by where their function is defined
+        void RegisterSystem(sol::protected_function func, std::vector<AName> labels, std::vector<AName> beforeLabels)
         {
-            World->RegisterSystem([func](AWorld *world)
+            std::string key;
+            for (const AName &label : labels)
+            {
+                key += label.GetName() + ";";
+            }
+
+            if (key.empty())
+            {
+                key = GetFunctionSource(func) + ";";
+            }
+
+            auto it = SystemBindings.find(key);
+            if (it != SystemBindings.end())
+            {
+                it->second->Func = func;
+                return;
+            }
+
+            std::shared_ptr<ALuaSystemBinding> binding = std::make_shared<ALuaSystemBinding>();
+            binding->Func = func;
+            binding->Name = key.substr(0, key.size() - 1);
+
+            SystemBindings.emplace(key, binding);
+
+            ALuaProfiler *profiler = Profiler;
+            World->RegisterSystem([binding, profiler](AWorld *world)
                                   {
-                std::function<void(AWorld*)> f = func;
-                f(world); },
+                if (!binding->Func.valid())
+                {
+                    return;
+                }
+
+                if (profiler != nullptr)
+                {
+                    profiler->BeginSystem(&binding->Name);
+                }
+
+                // a broken script shouldn't take the engine down, it can be fixed and reloaded
+                sol::protected_function_result result = binding->Func(world);
+                if (!result.valid())
+                {
+                    sol::error error = result;
+                    std::cout << "ALuaWorld::RegisterSystem | Error: " << error.what() << std::endl;
+                }
+
+                if (profiler != nullptr)
+                {
+                    profiler->EndSystem();
+                } },
                                   labels, beforeLabels);
         }
 
+        // runs module.function(chunk, commands) on the worker states, see ALuaWorkerPool
+        // chunk has count, dt and a view array per component like ForEntityViewsInChunks,
+        // commands is the chunk's ALuaCommandBuffer
+        // systems are identified by their labels like with RegisterSystem, or by
+        // module and function when they have none
+        void RegisterParallelSystem(const std::string &module, const std::string &function, std::vector<AName> components, std::vector<AName> labels, std::vector<AName> beforeLabels)
+        {
+            if (Workers == nullptr)
+            {
+                return;
+            }
+
+            if (!Workers->IsRunning() && !Workers->Init(ScriptDirectory, World))
+            {
+                std::cout << "ALuaWorld::RegisterParallelSystem | Error: No worker states, " << module << "." << function << " won't run" << std::endl;
+                return;
+            }
+
+            std::string key;
+            for (const AName &label : labels)
+            {
+                key += label.GetName() + ";";
+            }
+
+            if (key.empty())
+            {
+                key = module + "." + function + ";";
+            }
+
+            auto it = ParallelSystemBindings.find(key);
+            if (it != ParallelSystemBindings.end())
+            {
+                ALuaParallelSystemBinding &binding = *it->second;
+                binding.Module = module;
+                binding.Function = function;
+                binding.Components = components;
+                binding.Id = Workers->NewBindingId();
+                return;
+            }
+
+            std::shared_ptr<ALuaParallelSystemBinding> binding = std::make_shared<ALuaParallelSystemBinding>();
+            binding->Module = module;
+            binding->Function = function;
+            binding->Components = components;
+            binding->Id = Workers->NewBindingId();
+
+            ParallelSystemBindings.emplace(key, binding);
+
+            ALuaWorkerPool *workers = Workers;
+            sol::state *lua = Lua;
+            World->RegisterSystem([binding, workers, lua](AWorld *world)
+                                  { workers->Run(world, *binding, *lua, GetFrameTime()); },
+                                  labels, beforeLabels);
+        }
+
+        // the systems are gone after a game lib hot reload, or about to be on unload
+        void ClearSystemBindings()
+        {
+            for (auto &[key, binding] : SystemBindings)
+            {
+                binding->Func = sol::protected_function();
+            }
+
+            SystemBindings.clear();
+
+            for (auto &[key, binding] : ParallelSystemBindings)
+            {
+                binding->Id = 0;
+            }
+
+            ParallelSystemBindings.clear();
+
+            if (Workers != nullptr)
+            {
+                Workers->ClearFunctions();
+            }
+        }
+
         AEntity *NewEntity()
         {
             return World->NewObject_Internal<AEntity>();
         }
 
-        AComponent *NewComponent(const std::string &name)
+        sol::object NewComponent(const std::string &name, sol::this_state L)
         {
             AComponent *newComponent = World->NewObject_Internal<AComponent>(name);
-            return newComponent;
+            return ToLuaObject(L, newComponent);
+        }
+
+        // the component as its generated usertype if its class has one, so property
+        // access doesn't go through GetPropertyScripting
+        static sol::object ToLuaObject(lua_State *L, AComponent *component)
+        {
+            if (component == nullptr)
+            {
+                return sol::make_object(L, sol::lua_nil);
+            }
+
+            const AClassData &classData = component->GetClassData();
+            if (classData.LuaPush == nullptr)
+            {
+                return sol::make_object(L, component);
+            }
+
+            classData.LuaPush(L, component);
+            return sol::stack::pop<sol::object>(L);
         }
 
         void AddComponentToEntity(AEntity *entity, AComponent *component)
@@ -196,23 +448,398 @@ namespace Atlantis
             World->ForEntitiesWithComponents(componentMask, f);
         }
 
+        // calls func once per ChunkSize entities instead of once per entity, with the
+        // numeric properties of the components copied into arrays:
+        //   chunk.count, chunk.<component>.<property>[1..count]
+        // the arrays get written back to the components after each call, so the script
+        // can modify them in place
+        // the tables are reused between chunks, entries past count are left over from
+        // the previous chunk
+        void ForEntitiesInChunks(std::vector<AName> components, sol::function func)
+        {
+            lua_State *L = Lua->lua_state();
+            ComponentBitset componentMask = World->GetComponentMaskForComponents(components);
+
+            struct AColumn
+            {
+                size_t Component;
+                size_t Offset;
+                EPropertyKind Kind;
+                int StackIndex;
+            };
+
+            int top = lua_gettop(L);
+            lua_createtable(L, 0, (int)components.size() + 1);
+            int chunkIndex = lua_gettop(L);
+
+            std::vector<AColumn> columns;
+            for (size_t i = 0; i < components.size(); i++)
+            {
+                auto it = World->CDOs.find(components[i]);
+                if (it == World->CDOs.end())
+                {
+                    std::cout << "ALuaWorld::ForEntitiesInChunks | Error: " << components[i].GetName() << " isn't registered" << std::endl;
+                    lua_settop(L, top);
+                    return;
+                }
+
+                const AClassData &classData = it->second->GetClassData();
+
+                lua_createtable(L, 0, (int)classData.Properties.size());
+                int componentIndex = lua_gettop(L);
+
+                for (const auto &propData : classData.Properties)
+                {
+                    EPropertyKind kind = propData.GetKind();
+                    if (kind != EPropertyKind::Int && kind != EPropertyKind::Float && kind != EPropertyKind::Double && kind != EPropertyKind::Bool)
+                    {
+                        continue;
+                    }
+
+                    if (!lua_checkstack(L, 2))
+                    {
+                        std::cout << "ALuaWorld::ForEntitiesInChunks | Error: Too many properties" << std::endl;
+                        lua_settop(L, top);
+                        return;
+                    }
+
+                    lua_createtable(L, ChunkSize, 0);
+                    lua_pushvalue(L, -1);
+                    lua_setfield(L, componentIndex, propData.Name.GetName().c_str());
+
+                    columns.push_back({i, propData.Offset, kind, lua_gettop(L)});
+                }
+
+                // the column tables stay on the stack, only the component table goes
+                lua_pushvalue(L, componentIndex);
+                lua_setfield(L, chunkIndex, components[i].GetName().c_str());
+                lua_remove(L, componentIndex);
+                for (size_t c = 0; c < columns.size(); c++)
+                {
+                    if (columns[c].StackIndex > componentIndex)
+                    {
+                        columns[c].StackIndex--;
+                    }
+                }
+            }
+
+            const auto &entities = World->GetObjectsByName("AEntity");
+
+            // entity major, ChunkSize x components
+            std::vector<AComponent *> chunkComponents;
+            chunkComponents.reserve(ChunkSize * components.size());
+
+            size_t index = 0;
+            while (index < entities.size())
+            {
+                chunkComponents.clear();
+
+                int count = 0;
+                for (; index < entities.size() && count < ChunkSize; index++)
+                {
+                    AEntity *entity = static_cast<AEntity *>(entities[index].get());
+                    if (!entity->_isAlive || !entity->HasComponentsByMask(componentMask))
+                    {
+                        continue;
+                    }
+
+                    for (const AName &name : components)
+                    {
+                        chunkComponents.push_back(entity->GetComponentOfType(name));
+                    }
+
+                    count++;
+                }
+
+                if (count == 0)
+                {
+                    break;
+                }
+
+                for (const AColumn &column : columns)
+                {
+                    for (int i = 0; i < count; i++)
+                    {
+                        void *val = (void *)((size_t)chunkComponents[i * components.size() + column.Component] + column.Offset);
+
+                        switch (column.Kind)
+                        {
+                        case EPropertyKind::Int:
+                            lua_pushnumber(L, *static_cast<int *>(val));
+                            break;
+                        case EPropertyKind::Float:
+                            lua_pushnumber(L, *static_cast<float *>(val));
+                            break;
+                        case EPropertyKind::Double:
+                            lua_pushnumber(L, *static_cast<double *>(val));
+                            break;
+                        default:
+                            lua_pushboolean(L, *static_cast<bool *>(val));
+                            break;
+                        }
+
+                        lua_rawseti(L, column.StackIndex, i + 1);
+                    }
+                }
+
+                lua_pushinteger(L, count);
+                lua_setfield(L, chunkIndex, "count");
+
+                func.push(L);
+                lua_pushvalue(L, chunkIndex);
+                if (lua_pcall(L, 1, 0, 0) != 0)
+                {
+                    // nothing gets written back, the chunk may be half processed
+                    const char *message = lua_tostring(L, -1);
+                    std::cout << "ALuaWorld::ForEntitiesInChunks | Error: " << (message != nullptr ? message : "unknown error") << std::endl;
+                    break;
+                }
+
+                for (const AColumn &column : columns)
+                {
+                    for (int i = 0; i < count; i++)
+                    {
+                        void *val = (void *)((size_t)chunkComponents[i * components.size() + column.Component] + column.Offset);
+
+                        lua_rawgeti(L, column.StackIndex, i + 1);
+                        switch (column.Kind)
+                        {
+                        case EPropertyKind::Int:
+                            *static_cast<int *>(val) = (int)lua_tonumber(L, -1);
+                            break;
+                        case EPropertyKind::Float:
+                            *static_cast<float *>(val) = (float)lua_tonumber(L, -1);
+                            break;
+                        case EPropertyKind::Double:
+                            *static_cast<double *>(val) = lua_tonumber(L, -1);
+                            break;
+                        default:
+                            *static_cast<bool *>(val) = lua_toboolean(L, -1);
+                            break;
+                        }
+                        lua_pop(L, 1);
+                    }
+                }
+            }
+
+            lua_settop(L, top);
+        }
+
+        // like ForEntitiesInChunks, but chunk.<component> is an ffi array of pointers
+        // straight to the components, indexed from 0 to count - 1, so nothing is copied
+        // the arrays are only valid during the call
+        void ForEntityViewsInChunks(std::vector<AName> components, sol::protected_function func)
+        {
+            if (Views == nullptr || !Views->IsAvailable())
+            {
+                std::cout << "ALuaWorld::ForEntityViewsInChunks | Error: Component views aren't available" << std::endl;
+                return;
+            }
+
+            ComponentBitset componentMask = World->GetComponentMaskForComponents(components);
+
+            // component major, so each component's pointers are one array
+            std::vector<AComponent *> chunkComponents(ChunkSize * components.size(), nullptr);
+
+            sol::table chunk = Lua->create_table();
+            for (size_t c = 0; c < components.size(); c++)
+            {
+                auto it = World->CDOs.find(components[c]);
+                sol::object view = it != World->CDOs.end() ? Views->GetArrayView(it->second->GetClassData().Name, &chunkComponents[c * ChunkSize]) : sol::object();
+                if (!view.valid())
+                {
+                    std::cout << "ALuaWorld::ForEntityViewsInChunks | Error: " << components[c].GetName() << " has no view" << std::endl;
+                    return;
+                }
+
+                chunk[components[c].GetName()] = view;
+            }
+
+            const auto &entities = World->GetObjectsByName("AEntity");
+
+            size_t index = 0;
+            while (index < entities.size())
+            {
+                int count = 0;
+                for (; index < entities.size() && count < ChunkSize; index++)
+                {
+                    AEntity *entity = static_cast<AEntity *>(entities[index].get());
+                    if (!entity->_isAlive || !entity->HasComponentsByMask(componentMask))
+                    {
+                        continue;
+                    }
+
+                    for (size_t c = 0; c < components.size(); c++)
+                    {
+                        chunkComponents[c * ChunkSize + count] = entity->GetComponentOfType(components[c]);
+                    }
+
+                    count++;
+                }
+
+                if (count == 0)
+                {
+                    break;
+                }
+
+                chunk["count"] = count;
+
+                sol::protected_function_result result = func(chunk);
+                if (!result.valid())
+                {
+                    sol::error error = result;
+                    std::cout << "ALuaWorld::ForEntityViewsInChunks | Error: " << error.what() << std::endl;
+                    break;
+                }
+            }
+        }
+
         float GetDeltaTime()
         {
             return GetFrameTime();
         }
+
+    private:
+        void RegisterSchema(const ALuaComponentSchema &schema)
+        {
+            std::unique_ptr<AObject> cdo = CDynamicComponent::MakeCDO(schema.ClassData.get());
+            if (!schema.Defaults.empty())
+            {
+                memcpy((uint8_t *)cdo.get() + sizeof(CDynamicComponent), schema.Defaults.data(), schema.Defaults.size());
+            }
+
+            World->RegisterDynamic(*schema.ClassData, std::move(cdo));
+        }
+
+        // file:line of the function's definition, stays the same across script reloads
+        // as long as the function doesn't move
+        static std::string GetFunctionSource(const sol::protected_function &func)
+        {
+            lua_State *L = func.lua_state();
+            lua_Debug ar;
+
+            func.push(L);
+            if (lua_getinfo(L, ">S", &ar) == 0)
+            {
+                return "unknown";
+            }
+
+            return std::string(ar.short_src) + ":" + std::to_string(ar.linedefined);
+        }
+
+        static bool IsSameSchema(const AClassData &a, const AClassData &b)
+        {
+            if (a.Size != b.Size || a.Properties.size() != b.Properties.size())
+            {
+                return false;
+            }
+
+            for (size_t i = 0; i < a.Properties.size(); i++)
+            {
+                if (!(a.Properties[i].Name == b.Properties[i].Name) || !(a.Properties[i].Type == b.Properties[i].Type))
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        // properties are the bytes after the CDynamicComponent, value may be nil
+        static void WriteDefault(const APropertyData &propData, const sol::object &value, uint8_t *properties)
+        {
+            void *val = properties + propData.Offset - sizeof(CDynamicComponent);
+
+            switch (propData.GetKind())
+            {
+            case EPropertyKind::Bool:
+                *static_cast<bool *>(val) = value.is<bool>() ? value.as<bool>() : false;
+                break;
+            case EPropertyKind::Int:
+                *static_cast<int *>(val) = value.is<double>() ? (int)value.as<double>() : 0;
+                break;
+            case EPropertyKind::Float:
+                *static_cast<float *>(val) = value.is<double>() ? (float)value.as<double>() : 0.0f;
+                break;
+            case EPropertyKind::Double:
+                *static_cast<double *>(val) = value.is<double>() ? value.as<double>() : 0.0;
+                break;
+            case EPropertyKind::Color:
+                if (value.is<sol::table>())
+                {
+                    sol::table color = value.as<sol::table>();
+                    *static_cast<Color *>(val) = {color.get_or<unsigned char>("r", 0), color.get_or<unsigned char>("g", 0), color.get_or<unsigned char>("b", 0), color.get_or<unsigned char>("a", 255)};
+                }
+                break;
+            default:
+                break;
+            }
+        }
+
+        std::unordered_map<std::string, std::shared_ptr<ALuaSystemBinding>> SystemBindings;
+        std::unordered_map<std::string, std::shared_ptr<ALuaParallelSystemBinding>> ParallelSystemBindings;
+        std::map<AName, ALuaComponentSchema, ANameComparer> ComponentSchemas;
+    };
+
+    enum class ELuaGCMode : uint8_t
+    {
+        // lua's own heuristics decide when to collect, in the middle of a system if
+        // that's where the allocation happens
+        Automatic,
+        // the collector only runs in DoLua, for up to BudgetMs per frame
+        Budgeted,
+        // lua 5.4's generational collector, Automatic on LuaJIT and older versions
+        Generational
+    };
+
+    struct ALuaGCSettings
+    {
+        ELuaGCMode Mode = ELuaGCMode::Budgeted;
+
+        // incremental collector tuning, like collectgarbage("setpause") and ("setstepmul")
+        int Pause = 200;
+        int StepMultiplier = 200;
+
+        // Budgeted only, kilobytes of work per step, steps repeat until the budget is used
+        float BudgetMs = 1.0f;
+        int StepKb = 16;
+    };
+
+    struct ALuaGCStats
+    {
+        size_t HeapBytes = 0;
+        float LastStepMs = 0.0f;
+        size_t CompletedCycles = 0;
+        // frames that ignored the budget because the heap grew faster than it got collected
+        size_t OverBudgetFrames = 0;
     };
 
     struct ALuaRuntime
     {
         sol::state Lua;
         ALuaWorld LuaWorld;
+        ALuaComponentViews ComponentViews;
+        ALuaWorkerPool Workers;
+        ALuaProfiler Profiler;
+
+        // script RunScript started with, modules next to it can be required
+        std::filesystem::path MainScript;
 
+        // runs Init() once, then RegisterSystems() which runs again after every reload
         void RunScript(const std::string &file)
         {
             if (std::filesystem::exists(file))
             {
+                MainScript = file;
+                LuaWorld.ScriptDirectory = MainScript.parent_path();
+
+                std::string packagePath = Lua["package"]["path"];
+                Lua["package"]["path"] = (MainScript.parent_path() / "?.lua").string() + ";" + packagePath;
+
                 Lua.script_file(file);
                 Lua.script("Init()");
+
+                CallScriptFunction("RegisterSystems");
             }
             else
             {
@@ -220,10 +847,63 @@ namespace Atlantis
             }
         }
 
+        // runs the main script again after path changed, keeping the world as it is
+        // path is dropped from package.loaded so require loads it again, modules that
+        // didn't change keep their state
+        // systems get re-bound by RegisterSystems(), systems whose labels changed or
+        // that aren't registered anymore are left as they are
+        void ReloadScript(const std::filesystem::path &path)
+        {
+            if (MainScript.empty() || path.extension() != ".lua")
+            {
+                return;
+            }
+
+            std::filesystem::path modulePath = std::filesystem::relative(path, MainScript.parent_path()).replace_extension();
+            std::string moduleName = modulePath.generic_string();
+            std::replace(moduleName.begin(), moduleName.end(), '/', '.');
+            Lua["package"]["loaded"][moduleName] = sol::lua_nil;
+            Workers.ReloadModule(moduleName);
+
+            sol::protected_function_result result = Lua.safe_script_file(MainScript.string(), sol::script_pass_on_error);
+            if (!result.valid())
+            {
+                sol::error error = result;
+                std::cout << "ALuaRuntime::ReloadScript | Error: " << error.what() << std::endl;
+                return;
+            }
+
+            CallScriptFunction("RegisterSystems");
+
+            std::cout << "Reloaded lua script " << path.filename() << std::endl;
+        }
+
+        // calls a global function of the script if it has one
+        void CallScriptFunction(const std::string &name)
+        {
+            sol::object object = Lua[name];
+            if (object.get_type() != sol::type::function)
+            {
+                return;
+            }
+
+            sol::protected_function func = object;
+            sol::protected_function_result result = func();
+            if (!result.valid())
+            {
+                sol::error error = result;
+                std::cout << "ALuaRuntime::CallScriptFunction | Error: " << name << ": " << error.what() << std::endl;
+            }
+        }
+
         void InitLua()
         {
             // open some common libraries
-            Lua.open_libraries(sol::lib::base, sol::lib::package, sol::lib::math);
+            Lua.open_libraries(sol::lib::base, sol::lib::package, sol::lib::math, sol::lib::ffi, sol::lib::jit);
+
+            ApplyGCSettings();
+
+            ComponentViews.Init(Lua);
 
             Lua.set_function("RegisterEntity", &ALuaWorld::RegisterEntity, &LuaWorld);
             Lua.set_function("RegisterComponent", &ALuaWorld::RegisterComponent, &LuaWorld);
@@ -234,6 +914,11 @@ namespace Atlantis
             Lua.set_function("GetTexture", &ALuaWorld::GetTexture, &LuaWorld);
             Lua.set_function("GetEntitiesWithComponents", &ALuaWorld::GetEntitiesWithComponents, &LuaWorld);
             Lua.set_function("ForEntitiesWithComponents", &ALuaWorld::ForEntitiesWithComponents, &LuaWorld);
+            Lua.set_function("ForEntitiesInChunks", &ALuaWorld::ForEntitiesInChunks, &LuaWorld);
+            Lua.set_function("ForEntityViewsInChunks", &ALuaWorld::ForEntityViewsInChunks, &LuaWorld);
+            Lua.set_function("RegisterParallelSystem", &ALuaWorld::RegisterParallelSystem, &LuaWorld);
+            Lua.set_function("ComponentView", [this](AComponent *component, sol::this_state L)
+                             { return ComponentViews.GetView(L, component); });
             Lua.set_function("GetDeltaTime", &ALuaWorld::GetDeltaTime, &LuaWorld);
 
             sol::usertype<AName> name_type = Lua.new_usertype<AName>("AName",
@@ -245,49 +930,237 @@ namespace Atlantis
             sol::usertype<AWorld> world_type = Lua.new_usertype<AWorld>("AWorld");
             //world_type["GetEntitiesWithComponents"] = getEntitiesWithComponents;
 
-            AComponent *(AEntity::*getComponentOfType)(const AName &name) const = &AEntity::GetComponentOfType;
             sol::usertype<AEntity> entity_type = Lua.new_usertype<AEntity>("AEntity");
             entity_type["AddComponent"] = &AEntity::AddComponent;
-            entity_type["GetComponentOfType"] = getComponentOfType;
+            entity_type["GetComponentOfType"] = [](const AEntity &entity, const AName &name, sol::this_state L)
+            {
+                return ALuaWorld::ToLuaObject(L, entity.GetComponentOfType(name));
+            };
 
+            sol::usertype<APropertyHandle> handle_type = Lua.new_usertype<APropertyHandle>("APropertyHandle",
+                                                                                          sol::no_constructor,
+                                                                                          "IsValid", &APropertyHandle::IsValid);
+
+            // resolve a handle once with GetPropertyHandle("name"), then Get(handle) and
+            // Set(handle, value) skip the lookup
             sol::usertype<AComponent> component_type = Lua.new_usertype<AComponent>("AComponent",
-                                                                                    "GetPropertyInt", &AComponent::GetProperty<int>,
-                                                                                    "GetPropertyFloat", &AComponent::GetProperty<float>,
-                                                                                    "GetPropertyString", &AComponent::GetProperty<std::string>,
-                                                                                    "GetPropertyBool", &AComponent::GetProperty<bool>,
-                                                                                    "GetPropertyResourceHandle", &AComponent::GetProperty<AResourceHandle>,
-                                                                                    "SetPropertyInt", &AComponent::SetProperty<int>,
-                                                                                    "SetPropertyFloat", &AComponent::SetProperty<float>,
-                                                                                    "SetPropertyString", &AComponent::SetProperty<std::string>,
-                                                                                    "SetPropertyBool", &AComponent::SetProperty<bool>,
-                                                                                    "SetPropertyResourceHandle", &AComponent::SetProperty<AResourceHandle>,
+                                                                                    "GetPropertyInt", GetPropertyByName<int>,
+                                                                                    "GetPropertyFloat", GetPropertyByName<float>,
+                                                                                    "GetPropertyString", GetPropertyByName<std::string>,
+                                                                                    "GetPropertyBool", GetPropertyByName<bool>,
+                                                                                    "GetPropertyResourceHandle", GetPropertyByName<AResourceHandle>,
+                                                                                    "SetPropertyInt", SetPropertyByName<int>,
+                                                                                    "SetPropertyFloat", SetPropertyByName<float>,
+                                                                                    "SetPropertyString", SetPropertyByName<std::string>,
+                                                                                    "SetPropertyBool", SetPropertyByName<bool>,
+                                                                                    "SetPropertyResourceHandle", SetPropertyByName<AResourceHandle>,
+                                                                                    "GetPropertyHandle", [](const AComponent &component, const std::string &name)
+                                                                                    { return component.GetPropertyHandle(name); },
+                                                                                    "Get", [](AComponent &component, const APropertyHandle &handle, sol::this_state L)
+                                                                                    { return CheckPropertyHandle(component, handle) ? GetPropertyLua(L, handle.Kind, handle.GetPtr<void>(&component)) : sol::make_object(L, sol::lua_nil); },
+                                                                                    "Set", [](AComponent &component, const APropertyHandle &handle, sol::stack_object value)
+                                                                                    {
+                                                                                        if (CheckPropertyHandle(component, handle))
+                                                                                        {
+                                                                                            SetPropertyLua(handle.Kind, handle.GetPtr<void>(&component), value);
+                                                                                        } },
                                                                                     sol::meta_function::index,
                                                                                     &AComponent::GetPropertyScripting<sol::object, sol::stack_object, sol::this_state>,
                                                                                     sol::meta_function::new_index,
                                                                                     &AComponent::SetPropertyScripting<sol::stack_object, sol::stack_object, sol::this_state>);
-
-            // TODO: generate something usable for this from the header parser
-            /*SCRIPTING_EXPOSE_COMPONENT(CPosition);
-            SCRIPTING_EXPOSE_COMPONENT(CVelocity);
-            type_CPosition["x"] = &CPosition::x;
-            type_CPosition["y"] = &CPosition::y;
-            type_CVelocity["x"] = &CVelocity::x;
-            type_CVelocity["y"] = &CVelocity::y;*/
         }
 
         void SetWorld(AWorld *world)
         {
             LuaWorld.World = world;
             LuaWorld.SetState(&Lua);
+            LuaWorld.Views = &ComponentViews;
+            LuaWorld.Workers = &Workers;
+            LuaWorld.Profiler = &Profiler;
+
+            RegisterComponentTypes();
         }
 
+        // generated usertypes and ffi structs of the registered component types, types
+        // that were registered before are skipped until the next hot reload
+        void RegisterComponentTypes()
+        {
+            ComponentViews.Register(LuaWorld.World);
+            Workers.RegisterTypes(LuaWorld.World);
+
+            for (const auto &[name, cdo] : LuaWorld.World->CDOs)
+            {
+                if (dynamic_cast<AComponent *>(cdo.get()) == nullptr)
+                {
+                    continue;
+                }
+
+                const AClassData &classData = cdo->GetClassData();
+                if (classData.LuaRegister == nullptr)
+                {
+                    continue;
+                }
+
+                if (!RegisteredTypes.insert(classData.Name).second)
+                {
+                    continue;
+                }
+
+                classData.LuaRegister(Lua.lua_state());
+            }
+        }
+
+        // call again after changing GCSettings, worker states keep lua's own heuristics
+        void ApplyGCSettings()
+        {
+            lua_State *L = Lua.lua_state();
+
+#ifdef LUA_GCGEN
+            if (GCSettings.Mode == ELuaGCMode::Generational)
+            {
+                lua_gc(L, LUA_GCGEN, 0, 0);
+            }
+            else
+            {
+                lua_gc(L, LUA_GCINC, 0, 0, 0);
+            }
+#endif
+
+            lua_gc(L, LUA_GCSETPAUSE, GCSettings.Pause);
+            lua_gc(L, LUA_GCSETSTEPMUL, GCSettings.StepMultiplier);
+
+            if (GCSettings.Mode == ELuaGCMode::Budgeted)
+            {
+                lua_gc(L, LUA_GCSTOP, 0);
+                HeapAfterCycle = Lua.memory_used();
+            }
+            else
+            {
+                lua_gc(L, LUA_GCRESTART, 0);
+            }
+        }
+
+        const ALuaGCStats &GetGCStats() const
+        {
+            return GCStats;
+        }
+
+        // called by the main loop once per frame, after the systems ran
         void DoLua()
         {
+            StepGC();
+            Profiler.EndFrame();
+
+            AMemoryTracker::SetLiveBytes(EMemoryTag::Lua, Lua.memory_used() + Workers.GetMemoryUsed());
+
+            if (AProfiler::IsCapturing())
+            {
+                AProfiler::SetCounter("LuaHeapBytes", GCStats.HeapBytes);
+                AProfiler::SetCounter("LuaGCMs", GCStats.LastStepMs);
+            }
+        }
+
+        // the world dropped all systems, lua ones included
+        void OnPostHotReload()
+        {
+            // the game lib's types come from the new lib now, it often maps at the old
+            // address so the register functions can't tell, rebind every type
+            RegisteredTypes.clear();
+            LuaWorld.RegisterComponentSchemas();
+            RegisterComponentTypes();
+
+            LuaWorld.ClearSystemBindings();
+            CallScriptFunction("RegisterSystems");
+        }
+
+        // starts sampling, or stops it and prints what was sampled
+        void ToggleProfiler()
+        {
+            if (!Profiler.IsRunning())
+            {
+                Profiler.Start(Lua);
+                return;
+            }
+
+            Profiler.Stop(Lua);
+            Profiler.PrintReport();
+            Profiler.Clear();
         }
 
         void UnloadLua()
         {
+            Profiler.Stop(Lua);
+
+            LuaWorld.ClearSystemBindings();
+        }
+
+        ALuaGCSettings GCSettings;
+
+    private:
+        // steps the stopped collector until the budget is used up or the cycle is done,
+        // if the heap outgrew twice what the pause allows the budget is ignored until
+        // the cycle completes, so the heap can't grow without bounds
+        void StepGC()
+        {
+            GCStats.LastStepMs = 0.0f;
+
+            if (GCSettings.Mode != ELuaGCMode::Budgeted)
+            {
+                GCStats.HeapBytes = Lua.memory_used();
+                return;
+            }
+
+            // like lua's own collector a cycle only starts once the heap grew by Pause percent
+            size_t heapBytes = Lua.memory_used();
+            if (!CycleRunning && heapBytes < HeapAfterCycle / 100 * GCSettings.Pause)
+            {
+                GCStats.HeapBytes = heapBytes;
+                return;
+            }
+
+            DO_PROFILE("ALuaRuntime::StepGC", DARKPURPLE);
+
+            lua_State *L = Lua.lua_state();
+            auto start = std::chrono::steady_clock::now();
+
+            CycleRunning = true;
+            bool overBudget = heapBytes > HeapAfterCycle / 100 * GCSettings.Pause * 2;
+            GCStats.OverBudgetFrames += overBudget ? 1 : 0;
+
+            float elapsed = 0.0f;
+            while (true)
+            {
+                bool cycleDone = lua_gc(L, LUA_GCSTEP, GCSettings.StepKb) != 0;
+                elapsed = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+                // the garbage made since belongs to the next cycle
+                if (cycleDone)
+                {
+                    GCStats.CompletedCycles++;
+                    HeapAfterCycle = Lua.memory_used();
+                    CycleRunning = false;
+                    break;
+                }
+
+                if (!overBudget && elapsed >= GCSettings.BudgetMs)
+                {
+                    break;
+                }
+            }
+
+            GCStats.LastStepMs = elapsed;
+
+            // stepping restarts the collector on some lua versions
+            lua_gc(L, LUA_GCSTOP, 0);
+
+            GCStats.HeapBytes = Lua.memory_used();
         }
+
+        ALuaGCStats GCStats;
+        size_t HeapAfterCycle = 0;
+        bool CycleRunning = false;
+
+        std::set<AName, ANameComparer> RegisteredTypes;
     };
 }
 #endif
\ No newline at end of file
@@ -0,0 +1,419 @@
+#ifndef LUAWORKERS_H
+#define LUAWORKERS_H
+#include <sol/sol.hpp>
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+#include "engine/core.h"
+#include "engine/scripting/luaComponentViews.h"
+
+namespace Atlantis
+{
+    // a lua function that runs on the worker states, module.function(chunk, commands)
+    struct ALuaParallelSystemBinding
+    {
+        std::string Module;
+        std::string Function;
+        std::vector<AName> Components;
+
+        // changes whenever the binding does, so workers look the function up again,
+        // 0 once the binding is cleared
+        uint64_t Id = 0;
+    };
+
+    // what a worker wants done on the main thread, recorded while it runs a chunk
+    struct ALuaCommandBuffer
+    {
+        using AArgument = std::variant<double, bool, std::string>;
+
+        struct ACall
+        {
+            std::string Function;
+            std::vector<AArgument> Args;
+        };
+
+        // entities of the chunk being run
+        const std::vector<AEntity *> *Entities = nullptr;
+
+        std::vector<AEntity *> DestroyedEntities;
+        std::vector<ACall> Calls;
+
+        // index is the entity's index in the chunk, the entity gets killed at the sync point
+        void DestroyEntity(int index)
+        {
+            if (Entities == nullptr || index < 0 || index >= (int)Entities->size())
+            {
+                return;
+            }
+
+            DestroyedEntities.push_back((*Entities)[index]);
+        }
+
+        // calls a global function of the main script after the system ran, only
+        // numbers, bools and strings can be passed
+        void Call(const std::string &function, sol::variadic_args args)
+        {
+            ACall call;
+            call.Function = function;
+
+            for (const auto &arg : args)
+            {
+                switch (arg.get_type())
+                {
+                case sol::type::number:
+                    call.Args.emplace_back(arg.as<double>());
+                    break;
+                case sol::type::boolean:
+                    call.Args.emplace_back(arg.as<bool>());
+                    break;
+                case sol::type::string:
+                    call.Args.emplace_back(arg.as<std::string>());
+                    break;
+                default:
+                    call.Args.emplace_back(false);
+                    break;
+                }
+            }
+
+            Calls.push_back(std::move(call));
+        }
+
+        void Clear()
+        {
+            DestroyedEntities.clear();
+            Calls.clear();
+        }
+    };
+
+    // lua states that run parallel systems over disjoint chunks of entities
+    //
+    // every worker has its own state with the script directory on its package.path,
+    // parallel systems require their module in each of them, so these modules can't
+    // use the world api, they only get component views (see ALuaComponentViews) and
+    // a command buffer
+    // chunks are handed to the workers round robin and the command buffers are
+    // executed in chunk order afterwards, so results don't depend on thread timing
+    struct ALuaWorkerPool
+    {
+        // entities per chunk
+        int ChunkSize = 1024;
+
+        // 0 uses one worker per hardware thread
+        int WorkerCount = 0;
+
+        bool IsRunning() const
+        {
+            return !Workers.empty();
+        }
+
+        bool Init(const std::filesystem::path &scriptDirectory, AWorld *world)
+        {
+            int count = WorkerCount > 0 ? WorkerCount : std::max(1, (int)std::thread::hardware_concurrency());
+
+            for (int i = 0; i < count; i++)
+            {
+                std::unique_ptr<ALuaWorker> worker = std::make_unique<ALuaWorker>();
+                sol::state &lua = worker->Lua;
+
+                lua.open_libraries(sol::lib::base, sol::lib::package, sol::lib::math, sol::lib::string, sol::lib::table, sol::lib::ffi, sol::lib::jit);
+
+                std::string packagePath = lua["package"]["path"];
+                lua["package"]["path"] = (scriptDirectory / "?.lua").string() + ";" + packagePath;
+
+                lua.new_usertype<ALuaCommandBuffer>("ALuaCommandBuffer",
+                                                    sol::no_constructor,
+                                                    "DestroyEntity", &ALuaCommandBuffer::DestroyEntity,
+                                                    "Call", &ALuaCommandBuffer::Call);
+
+                if (!worker->Views.Init(lua))
+                {
+                    std::cout << "ALuaWorkerPool::Init | Error: Workers need component views" << std::endl;
+                    Workers.clear();
+                    return false;
+                }
+
+                worker->Views.Register(world);
+                worker->Chunk = lua.create_table();
+
+                Workers.push_back(std::move(worker));
+            }
+
+            return true;
+        }
+
+        // ffi structs of types registered after Init or changed by a hot reload
+        void RegisterTypes(AWorld *world)
+        {
+            for (auto &worker : Workers)
+            {
+                worker->Views.Register(world);
+            }
+        }
+
+        // the module gets required again by every worker the next time it's used
+        void ReloadModule(const std::string &moduleName)
+        {
+            for (auto &worker : Workers)
+            {
+                worker->Lua["package"]["loaded"][moduleName] = sol::lua_nil;
+                worker->Functions.clear();
+            }
+        }
+
+        void ClearFunctions()
+        {
+            for (auto &worker : Workers)
+            {
+                worker->Functions.clear();
+            }
+        }
+
+        uint64_t NewBindingId()
+        {
+            return ++LastBindingId;
+        }
+
+        // runs binding over all entities that have its components, then the command
+        // buffers on this thread with mainLua
+        void Run(AWorld *world, const ALuaParallelSystemBinding &binding, sol::state &mainLua, float dt)
+        {
+            if (!IsRunning() || binding.Id == 0)
+            {
+                return;
+            }
+
+            std::vector<AName> classNames;
+            for (const AName &name : binding.Components)
+            {
+                auto it = world->CDOs.find(name);
+                if (it == world->CDOs.end())
+                {
+                    std::cout << "ALuaWorkerPool::Run | Error: " << name.GetName() << " isn't registered" << std::endl;
+                    return;
+                }
+
+                classNames.push_back(it->second->GetClassData().Name);
+            }
+
+            size_t chunkCount = GatherChunks(world, binding.Components);
+            if (chunkCount == 0)
+            {
+                return;
+            }
+
+            int workerCount = (int)Workers.size();
+
+#pragma omp parallel for
+            for (int w = 0; w < workerCount; w++)
+            {
+                for (size_t c = w; c < chunkCount; c += workerCount)
+                {
+                    RunChunk(*Workers[w], binding, classNames, Chunks[c], dt);
+                }
+            }
+
+            for (size_t c = 0; c < chunkCount; c++)
+            {
+                AChunk &chunk = Chunks[c];
+                if (!chunk.Error.empty())
+                {
+                    std::cout << "ALuaWorkerPool::Run | Error: " << binding.Module << "." << binding.Function << ": " << chunk.Error << std::endl;
+                }
+
+                // killed at the sync point like every other queued deletion
+                for (AEntity *entity : chunk.Commands.DestroyedEntities)
+                {
+                    world->QueueObjectDeletion(entity);
+                }
+
+                for (const ALuaCommandBuffer::ACall &call : chunk.Commands.Calls)
+                {
+                    RunCall(mainLua, call);
+                }
+            }
+        }
+
+        size_t GetMemoryUsed() const
+        {
+            size_t bytes = 0;
+            for (const auto &worker : Workers)
+            {
+                bytes += worker->Lua.memory_used();
+            }
+
+            return bytes;
+        }
+
+    private:
+        struct ALuaWorker
+        {
+            sol::state Lua;
+            ALuaComponentViews Views;
+
+            // reused for every chunk the worker runs
+            sol::table Chunk;
+
+            // binding id -> function
+            std::unordered_map<uint64_t, sol::protected_function> Functions;
+        };
+
+        struct AChunk
+        {
+            std::vector<AEntity *> Entities;
+
+            // component major, ChunkSize pointers per component
+            std::vector<AComponent *> Components;
+
+            ALuaCommandBuffer Commands;
+            std::string Error;
+        };
+
+        // returns the number of chunks filled
+        size_t GatherChunks(AWorld *world, const std::vector<AName> &components)
+        {
+            ComponentBitset componentMask = world->GetComponentMaskForComponents(components);
+            const auto &entities = world->GetObjectsByName("AEntity");
+
+            size_t chunkCount = 0;
+            AChunk *chunk = nullptr;
+
+            for (const auto &entityObj : entities)
+            {
+                AEntity *entity = static_cast<AEntity *>(entityObj.get());
+                if (!entity->_isAlive || !entity->HasComponentsByMask(componentMask))
+                {
+                    continue;
+                }
+
+                if (chunk == nullptr || chunk->Entities.size() == (size_t)ChunkSize)
+                {
+                    if (chunkCount == Chunks.size())
+                    {
+                        Chunks.emplace_back();
+                    }
+
+                    chunk = &Chunks[chunkCount++];
+                    chunk->Entities.clear();
+                    chunk->Components.assign(ChunkSize * components.size(), nullptr);
+                    chunk->Commands.Clear();
+                    chunk->Error.clear();
+                }
+
+                size_t index = chunk->Entities.size();
+                for (size_t c = 0; c < components.size(); c++)
+                {
+                    chunk->Components[c * ChunkSize + index] = entity->GetComponentOfType(components[c]);
+                }
+
+                chunk->Entities.push_back(entity);
+            }
+
+            return chunkCount;
+        }
+
+        // runs on a worker thread, only touches the worker's state and the chunk
+        void RunChunk(ALuaWorker &worker, const ALuaParallelSystemBinding &binding, const std::vector<AName> &classNames, AChunk &chunk, float dt)
+        {
+            sol::protected_function *func = GetFunction(worker, binding, chunk.Error);
+            if (func == nullptr)
+            {
+                return;
+            }
+
+            sol::table &view = worker.Chunk;
+            view["count"] = (int)chunk.Entities.size();
+            view["dt"] = dt;
+
+            for (size_t c = 0; c < classNames.size(); c++)
+            {
+                sol::object array = worker.Views.GetArrayView(classNames[c], &chunk.Components[c * ChunkSize]);
+                if (!array.valid())
+                {
+                    chunk.Error = classNames[c].GetName() + " has no view";
+                    return;
+                }
+
+                view[binding.Components[c].GetName()] = array;
+            }
+
+            chunk.Commands.Entities = &chunk.Entities;
+
+            sol::protected_function_result result = (*func)(view, &chunk.Commands);
+            if (!result.valid())
+            {
+                sol::error error = result;
+                chunk.Error = error.what();
+            }
+
+            chunk.Commands.Entities = nullptr;
+        }
+
+        sol::protected_function *GetFunction(ALuaWorker &worker, const ALuaParallelSystemBinding &binding, std::string &error)
+        {
+            auto it = worker.Functions.find(binding.Id);
+            if (it != worker.Functions.end())
+            {
+                return &it->second;
+            }
+
+            sol::protected_function require = worker.Lua["require"];
+            sol::protected_function_result result = require(binding.Module);
+            if (!result.valid())
+            {
+                sol::error requireError = result;
+                error = requireError.what();
+                return nullptr;
+            }
+
+            sol::object module = result.get<sol::object>();
+            sol::object func = module.get_type() == sol::type::table ? module.as<sol::table>()[binding.Function] : sol::object();
+            if (func.get_type() != sol::type::function)
+            {
+                error = "not a function";
+                return nullptr;
+            }
+
+            return &worker.Functions.insert_or_assign(binding.Id, func.as<sol::protected_function>()).first->second;
+        }
+
+        static void RunCall(sol::state &mainLua, const ALuaCommandBuffer::ACall &call)
+        {
+            sol::object object = mainLua[call.Function];
+            if (object.get_type() != sol::type::function)
+            {
+                std::cout << "ALuaWorkerPool::RunCall | Error: " << call.Function << " isn't a function" << std::endl;
+                return;
+            }
+
+            std::vector<sol::object> args;
+            for (const ALuaCommandBuffer::AArgument &arg : call.Args)
+            {
+                args.push_back(std::visit([&](const auto &value)
+                                          { return sol::make_object(mainLua, value); },
+                                          arg));
+            }
+
+            sol::protected_function func = object;
+            sol::protected_function_result result = func(sol::as_args(args));
+            if (!result.valid())
+            {
+                sol::error error = result;
+                std::cout << "ALuaWorkerPool::RunCall | Error: " << call.Function << ": " << error.what() << std::endl;
+            }
+        }
+
+        std::vector<std::unique_ptr<ALuaWorker>> Workers;
+
+        // reused between runs
+        std::vector<AChunk> Chunks;
+
+        uint64_t LastBindingId = 0;
+    };
+}
+#endif
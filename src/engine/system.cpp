@@ -1,12 +1,66 @@
 #include "system.h"
 #include "core.h"
+#include <algorithm>
 
 namespace Atlantis
 {
+  void ASystemStats::AddSample(float ms)
+  {
+    Samples[NextSample] = ms;
+    NextSample = (NextSample + 1) % WindowSize;
+    SampleCount = std::min(SampleCount + 1, WindowSize);
+    TotalCalls++;
+
+    LastMs = ms;
+
+    std::array<float, WindowSize> sorted;
+    std::copy(Samples.begin(), Samples.begin() + SampleCount, sorted.begin());
+
+    float total = 0.0f;
+    MinMs = sorted[0];
+    for (int i = 0; i < SampleCount; i++)
+    {
+      total += sorted[i];
+      MinMs = std::min(MinMs, sorted[i]);
+    }
+    AvgMs = total / SampleCount;
+
+    int p99Index = std::min(SampleCount - 1, (SampleCount * 99) / 100);
+    std::nth_element(sorted.begin(), sorted.begin() + p99Index, sorted.begin() + SampleCount);
+    P99Ms = sorted[p99Index];
+  }
+
   void ASystem::Process(AWorld *world)
   {
   }
 
+  void ASystem::BuildName()
+  {
+    std::vector<std::string> labels;
+    for (const AName &label : Labels)
+    {
+      labels.push_back(label.GetName());
+    }
+
+    // labels are unordered, sort them so the name is stable between runs
+    std::sort(labels.begin(), labels.end());
+
+    Name.clear();
+    for (const std::string &label : labels)
+    {
+      Name += Name.empty() ? label : "|" + label;
+    }
+
+    if (Name.empty())
+    {
+      Name = "Unnamed";
+    }
+  }
+
+  ASystem::~ASystem()
+  {
+  }
+
   void ALambdaSystem::Process(AWorld *world)
   {
     Lambda(world);
@@ -2,12 +2,43 @@
 #define SYSTEM_H
 
 #include "engine/reflection/reflectionHelpers.h"
+#include <array>
+#include <memory>
+#include <string>
 #include <unordered_set>
 #include <functional>
 
 namespace Atlantis
 {
   struct AWorld;
+  struct AProfileZoneDesc;
+
+  // rolling timings of a system, filled in by AWorld when processing systems
+  struct ASystemStats
+  {
+    static constexpr int WindowSize = 128;
+
+    // milliseconds, ring buffer of the last WindowSize calls
+    std::array<float, WindowSize> Samples = {};
+    int SampleCount = 0;
+    int NextSample = 0;
+
+    float LastMs = 0.0f;
+    float MinMs = 0.0f;
+    float AvgMs = 0.0f;
+    float P99Ms = 0.0f;
+
+    // entities iterated through AWorld::ForEntitiesWithComponents during the last call
+    size_t EntitiesProcessed = 0;
+
+    // timesliced systems only, how far through the entity list we are [0, 1]
+    float TimesliceProgress = 0.0f;
+    size_t TimesliceCycles = 0;
+
+    size_t TotalCalls = 0;
+
+    void AddSample(float ms);
+  };
 
   struct ASystem
   {
@@ -22,7 +53,26 @@ namespace Atlantis
 
     int CurrentObjectIndex = 0;
 
+    // profiling stuff
+    ASystemStats Stats;
+
+    // built from the labels when the system gets registered, the render thread
+    // reads it for the stats so it doesn't change after that
+    std::string Name;
+
+    // shared by systems with the same labels, outlives the system (see AProfiler::GetNamedZone)
+    const AProfileZoneDesc *ProfileZone = nullptr;
+
     virtual void Process(AWorld *world);
+
+    void BuildName();
+
+    const std::string &GetName() const
+    {
+      return Name;
+    }
+
+    virtual ~ASystem();
   };
 
   struct ALambdaSystem : public ASystem
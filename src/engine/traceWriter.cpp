@@ -0,0 +1,146 @@
+#include "engine/traceWriter.h"
+#include "engine/profiling.h"
+#include "fmt/core.h"
+#include "nlohmann/json.hpp"
+
+namespace Atlantis
+{
+    namespace
+    {
+        std::string EscapeString(const std::string &str)
+        {
+            return nlohmann::json(str).dump();
+        }
+
+        double NsToUs(uint64_t ns)
+        {
+            return ns / 1000.0;
+        }
+    }
+
+    bool ATraceWriter::Open(const std::string &path)
+    {
+        Close();
+
+        File.open(path, std::ios::out | std::ios::trunc);
+        if (!File.is_open())
+        {
+            return false;
+        }
+
+        Path = path;
+        FirstEvent = true;
+        NamedThreads.clear();
+
+        File << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+        BeginEvent();
+        File << R"({"name":"process_name","ph":"M","pid":0,"tid":0,"args":{"name":"AtlantisEngine"}})";
+
+        return true;
+    }
+
+    void ATraceWriter::Close()
+    {
+        if (!File.is_open())
+        {
+            return;
+        }
+
+        File << "\n]}\n";
+        File.close();
+    }
+
+    bool ATraceWriter::IsOpen() const
+    {
+        return File.is_open();
+    }
+
+    const std::string &ATraceWriter::GetPath() const
+    {
+        return Path;
+    }
+
+    void ATraceWriter::WriteZone(uint32_t threadIndex, const std::string &threadName, const AProfileZone &zone)
+    {
+        WriteThreadName(threadIndex, threadName);
+
+        BeginEvent();
+        File << fmt::format(R"({{"name":{},"ph":"X","pid":0,"tid":{},"ts":{:.3f},"dur":{:.3f}}})",
+                            EscapeString(zone.Zone->Name),
+                            threadIndex,
+                            NsToUs(zone.Start),
+                            NsToUs(zone.End - zone.Start));
+    }
+
+    void ATraceWriter::WriteFrame(uint32_t threadIndex, const std::string &threadName, uint64_t time)
+    {
+        WriteThreadName(threadIndex, threadName);
+
+        BeginEvent();
+        File << fmt::format(R"({{"name":"Frame","ph":"i","s":"t","pid":0,"tid":{},"ts":{:.3f}}})",
+                            threadIndex,
+                            NsToUs(time));
+    }
+
+    void ATraceWriter::WriteCounter(const std::string &name, uint64_t time, double value)
+    {
+        BeginEvent();
+        File << fmt::format(R"({{"name":{},"ph":"C","pid":0,"tid":0,"ts":{:.3f},"args":{{"value":{}}}}})",
+                            EscapeString(name),
+                            NsToUs(time),
+                            value);
+    }
+
+    void ATraceWriter::WriteInstant(const std::string &name, uint64_t time, const std::vector<std::pair<std::string, double>> &args)
+    {
+        nlohmann::json argsJson = nlohmann::json::object();
+        for (const auto &[argName, value] : args)
+        {
+            argsJson[argName] = value;
+        }
+
+        BeginEvent();
+        File << fmt::format(R"({{"name":{},"ph":"i","s":"g","pid":0,"tid":0,"ts":{:.3f},"args":{}}})",
+                            EscapeString(name),
+                            NsToUs(time),
+                            argsJson.dump());
+    }
+
+    void ATraceWriter::Flush()
+    {
+        if (File.is_open())
+        {
+            File.flush();
+        }
+    }
+
+    ATraceWriter::~ATraceWriter()
+    {
+        Close();
+    }
+
+    void ATraceWriter::WriteThreadName(uint32_t threadIndex, const std::string &threadName)
+    {
+        if (NamedThreads.contains(threadIndex))
+        {
+            return;
+        }
+
+        NamedThreads.insert(threadIndex);
+
+        BeginEvent();
+        File << fmt::format(R"({{"name":"thread_name","ph":"M","pid":0,"tid":{},"args":{{"name":{}}}}})",
+                            threadIndex,
+                            EscapeString(threadName));
+    }
+
+    void ATraceWriter::BeginEvent()
+    {
+        if (!FirstEvent)
+        {
+            File << ",\n";
+        }
+
+        FirstEvent = false;
+    }
+}
@@ -0,0 +1,52 @@
+#ifndef ATLANTIS_ENGINE_TRACEWRITER_H
+#define ATLANTIS_ENGINE_TRACEWRITER_H
+
+#include <fstream>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace Atlantis
+{
+    struct AProfileZone;
+
+    // streams events in the Chrome trace event format, the result can be
+    // opened in chrome://tracing or ui.perfetto.dev
+    struct ATraceWriter
+    {
+        bool Open(const std::string &path);
+
+        void Close();
+
+        bool IsOpen() const;
+
+        const std::string &GetPath() const;
+
+        // times are in nanoseconds since the profiler started
+        void WriteZone(uint32_t threadIndex, const std::string &threadName, const AProfileZone &zone);
+
+        void WriteFrame(uint32_t threadIndex, const std::string &threadName, uint64_t time);
+
+        void WriteCounter(const std::string &name, uint64_t time, double value);
+
+        // a global instant event with args
+        void WriteInstant(const std::string &name, uint64_t time, const std::vector<std::pair<std::string, double>> &args);
+
+        void Flush();
+
+        ~ATraceWriter();
+
+    private:
+        void WriteThreadName(uint32_t threadIndex, const std::string &threadName);
+
+        void BeginEvent();
+
+        std::ofstream File;
+        std::string Path;
+        bool FirstEvent = true;
+        std::unordered_set<uint32_t> NamedThreads;
+    };
+}
+
+#endif // ATLANTIS_ENGINE_TRACEWRITER_H
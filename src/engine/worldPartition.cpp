@@ -0,0 +1,336 @@
+#include "engine/worldPartition.h"
+#include "engine/renderer/renderer.h"
+#include <cmath>
+#include <filesystem>
+#include <iostream>
+
+namespace Atlantis
+{
+    namespace
+    {
+        float GetElapsedMs(std::chrono::steady_clock::time_point start)
+        {
+            return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+
+        bool IsReady(const std::future<bool> &future)
+        {
+            return future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+        }
+    }
+
+    SWorldPartition::SWorldPartition(const std::string &directory)
+    {
+        Directory = directory;
+
+        std::filesystem::create_directories(Directory);
+    }
+
+    SWorldPartition::~SWorldPartition()
+    {
+        // reads write to their cell's loader, let them finish before it's freed
+        for (auto &[key, cell] : Cells)
+        {
+            if (cell.Io.valid())
+            {
+                cell.Io.wait();
+            }
+        }
+
+        Cells.clear();
+    }
+
+    void SWorldPartition::Process(AWorld *world)
+    {
+        // cameras and positions are shared with the render thread, do everything at the sync point
+        if (SyncQueued)
+        {
+            return;
+        }
+
+        SyncQueued = true;
+
+        std::weak_ptr<bool> alive = AliveToken;
+        world->QueueSyncPoint([this, alive, world]()
+                              {
+            if (alive.expired())
+            {
+                return;
+            }
+
+            SyncQueued = false;
+            ProcessSyncPoint(world); });
+    }
+
+    size_t SWorldPartition::GetLoadedCellCount() const
+    {
+        size_t count = 0;
+        for (const auto &[key, cell] : Cells)
+        {
+            count += cell.State == ECellState::Loaded ? 1 : 0;
+        }
+
+        return count;
+    }
+
+    size_t SWorldPartition::GetPendingCellCount() const
+    {
+        size_t count = 0;
+        for (const auto &[key, cell] : Cells)
+        {
+            count += (cell.State == ECellState::Reading || cell.State == ECellState::Restoring || cell.State == ECellState::Writing) ? 1 : 0;
+        }
+
+        return count;
+    }
+
+    int64_t SWorldPartition::GetCellKey(int x, int y)
+    {
+        return ((int64_t)x << 32) | (uint32_t)y;
+    }
+
+    std::string SWorldPartition::GetCellPath(int x, int y) const
+    {
+        return Directory + "/cell_" + std::to_string(x) + "_" + std::to_string(y) + ".asnp";
+    }
+
+    int SWorldPartition::GetCellIndex(float position) const
+    {
+        return (int)std::floor(position / CellSize);
+    }
+
+    SWorldPartition::ACell &SWorldPartition::GetCell(int x, int y)
+    {
+        auto it = Cells.find(GetCellKey(x, y));
+        if (it != Cells.end())
+        {
+            return it->second;
+        }
+
+        // cells we haven't seen yet only need loading if an earlier session wrote them
+        ACell &cell = Cells[GetCellKey(x, y)];
+        cell.X = x;
+        cell.Y = y;
+        cell.State = std::filesystem::exists(GetCellPath(x, y)) ? ECellState::Unloaded : ECellState::Loaded;
+
+        return cell;
+    }
+
+    void SWorldPartition::ProcessSyncPoint(AWorld *world)
+    {
+        DO_PROFILE("SWorldPartition::ProcessSyncPoint", DARKGREEN);
+
+        const auto &cameras = world->GetEntitiesWithComponents<CCamera, CPosition>();
+        if (cameras.empty())
+        {
+            return;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+
+        CPosition *cameraPos = cameras[0]->GetComponentOfType<CPosition>();
+        int cameraX = GetCellIndex(cameraPos->x);
+        int cameraY = GetCellIndex(cameraPos->y);
+
+        if (!HasCameraCell || cameraX != CameraCellX || cameraY != CameraCellY)
+        {
+            HasCameraCell = true;
+            CameraCellX = cameraX;
+            CameraCellY = cameraY;
+
+            // start over, the buckets were collected for the old camera cell
+            UnloadPending = true;
+            UnloadScanIndex = 0;
+            UnloadBuckets.clear();
+        }
+
+        PollIo();
+        RequestLoads(cameraX, cameraY);
+
+        if (UnloadPending)
+        {
+            UnloadPending = !UnloadCells(world, cameraX, cameraY, start);
+        }
+
+        RestoreCells(world, start);
+    }
+
+    void SWorldPartition::PollIo()
+    {
+        for (auto &[key, cell] : Cells)
+        {
+            if (!cell.Io.valid() || !IsReady(cell.Io))
+            {
+                continue;
+            }
+
+            bool ok = cell.Io.get();
+
+            if (cell.State == ECellState::Reading)
+            {
+                if (ok)
+                {
+                    cell.State = ECellState::Restoring;
+                }
+                else
+                {
+                    // keep the file around, maybe it can be read later
+                    std::cout << "SWorldPartition::PollIo | Error: Could not read cell " << cell.X << ", " << cell.Y << std::endl;
+                    cell.Loader.reset();
+                    cell.State = ECellState::Unloaded;
+                }
+            }
+            else if (cell.State == ECellState::Writing)
+            {
+                if (!ok)
+                {
+                    std::cout << "SWorldPartition::PollIo | Error: Could not write cell " << cell.X << ", " << cell.Y << std::endl;
+                }
+
+                cell.State = ECellState::Unloaded;
+            }
+        }
+    }
+
+    void SWorldPartition::RequestLoads(int cameraX, int cameraY)
+    {
+        for (int y = cameraY - LoadRadius; y <= cameraY + LoadRadius; y++)
+        {
+            for (int x = cameraX - LoadRadius; x <= cameraX + LoadRadius; x++)
+            {
+                ACell &cell = GetCell(x, y);
+                if (cell.State != ECellState::Unloaded)
+                {
+                    continue;
+                }
+
+                cell.State = ECellState::Reading;
+                cell.Loader = std::make_unique<AWorldSnapshotLoader>();
+                cell.Io = std::async(std::launch::async, [loader = cell.Loader.get(), path = GetCellPath(x, y)]()
+                                     {
+                    AWorldSnapshot snapshot;
+                    return snapshot.Load(path) && loader->Begin(std::move(snapshot.Data)); });
+            }
+        }
+    }
+
+    bool SWorldPartition::UnloadCells(AWorld *world, int cameraX, int cameraY, std::chrono::steady_clock::time_point start)
+    {
+        const auto &entities = world->GetObjectsByName("AEntity");
+        ComponentBitset mask = world->GetComponentMaskForComponents({"CPartitioned", "CPosition"});
+
+        // bucket the loaded entities of far away cells, a few thousand entities per frame
+        while (UnloadScanIndex < entities.size())
+        {
+            AEntity *entity = static_cast<AEntity *>(entities[UnloadScanIndex].get());
+            UnloadScanIndex++;
+
+            if (entity->_isAlive && entity->HasComponentsByMask(mask))
+            {
+                CPosition *pos = entity->GetComponentOfType<CPosition>();
+                int x = GetCellIndex(pos->x);
+                int y = GetCellIndex(pos->y);
+
+                // entities in cells that aren't loaded are strays, they stay until the cell is loaded
+                bool far = std::abs(x - cameraX) > UnloadRadius || std::abs(y - cameraY) > UnloadRadius;
+                if (far && GetCell(x, y).State == ECellState::Loaded)
+                {
+                    UnloadBuckets[GetCellKey(x, y)].push_back(entity);
+                }
+            }
+
+            if (UnloadScanIndex % 1024 == 0 && GetElapsedMs(start) >= BudgetMs)
+            {
+                return false;
+            }
+        }
+
+        // at least one cell per frame, so a scan that used up the budget still gets somewhere
+        while (!UnloadBuckets.empty())
+        {
+            auto it = UnloadBuckets.begin();
+            ACell &cell = Cells[it->first];
+            std::vector<AEntity *> cellEntities;
+
+            // the buckets may be a few frames old by now
+            for (AEntity *entity : it->second)
+            {
+                if (entity->_isAlive && entity->HasComponentsByMask(mask))
+                {
+                    CPosition *pos = entity->GetComponentOfType<CPosition>();
+                    if (GetCellIndex(pos->x) == cell.X && GetCellIndex(pos->y) == cell.Y)
+                    {
+                        cellEntities.push_back(entity);
+                    }
+                }
+            }
+
+            UnloadBuckets.erase(it);
+
+            if (cell.State != ECellState::Loaded || cellEntities.empty())
+            {
+                continue;
+            }
+
+            auto snapshot = std::make_shared<AWorldSnapshot>();
+            snapshot->Capture(world, cellEntities, AWorldSnapshot::FlagDelta);
+
+            for (AEntity *entity : cellEntities)
+            {
+                entity->MarkObjectDead();
+            }
+
+            cell.State = ECellState::Writing;
+            cell.Io = std::async(std::launch::async, [snapshot, path = GetCellPath(cell.X, cell.Y)]()
+                                 { return snapshot->Write(path); });
+
+            if (GetElapsedMs(start) >= BudgetMs && !UnloadBuckets.empty())
+            {
+                return false;
+            }
+        }
+
+        UnloadScanIndex = 0;
+        return true;
+    }
+
+    void SWorldPartition::RestoreCells(AWorld *world, std::chrono::steady_clock::time_point start)
+    {
+        for (auto &[key, cell] : Cells)
+        {
+            if (cell.State != ECellState::Restoring)
+            {
+                continue;
+            }
+
+            float budget = BudgetMs - GetElapsedMs(start);
+            if (budget <= 0.0f)
+            {
+                return;
+            }
+
+            if (!cell.Loader->Step(world, budget))
+            {
+                return;
+            }
+
+            // a failed restore only brought back part of the cell, keep the file so the
+            // rest isn't lost, the next unload writes a new one next to it
+            std::string path = GetCellPath(cell.X, cell.Y);
+            if (cell.Loader->IsFailed())
+            {
+                std::cout << "SWorldPartition::RestoreCells | Error: Cell " << cell.X << ", " << cell.Y << " is corrupt, keeping it as " << path << ".corrupt" << std::endl;
+                std::filesystem::rename(path, path + ".corrupt");
+            }
+            else
+            {
+                std::filesystem::remove(path);
+            }
+            cell.Loader.reset();
+            cell.State = ECellState::Loaded;
+
+            // some entities may have been saved after walking out of the cell
+            UnloadPending = true;
+        }
+    }
+}
@@ -0,0 +1,119 @@
+#ifndef ATLANTIS_ENGINE_WORLDPARTITION_H
+#define ATLANTIS_ENGINE_WORLDPARTITION_H
+
+#include <chrono>
+#include <future>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include "engine/core.h"
+#include "engine/system.h"
+#include "engine/worldSnapshot.h"
+#include "./generated/worldPartition.gen.h"
+
+namespace Atlantis
+{
+    // entities with this get streamed out with the cell their CPosition is in,
+    // everything else (cameras, players, managers) always stays loaded
+    struct CPartitioned : public AComponent
+    {
+        DEF_CLASS();
+
+        CPartitioned() : AComponent(){};
+        CPartitioned(const CPartitioned &other){};
+    };
+
+    // streams square cells of CPartitioned entities in and out around the first CCamera
+    //
+    // cells within LoadRadius cells of the camera's cell are kept loaded, cells further
+    // than UnloadRadius are written to Directory/cell_<x>_<y>.asnp and their entities
+    // killed, the gap between the two keeps cells on the border from flip flopping
+    // file io and decompression run on background threads, creating and killing
+    // entities happens at the sync point, within BudgetMs per frame
+    //
+    // entities that move into a cell that isn't loaded stay loaded until that cell gets
+    // loaded and unloaded again
+    // cell files are kept until the cell is loaded back, remove Directory before
+    // starting a new game
+    struct SWorldPartition : public ASystem
+    {
+        float CellSize = 1024.0f;
+        int LoadRadius = 1;
+        int UnloadRadius = 2;
+        float BudgetMs = 2.0f;
+
+        std::string Directory;
+
+        SWorldPartition(const std::string &directory);
+
+        virtual ~SWorldPartition();
+
+        virtual void Process(AWorld *world) override;
+
+        size_t GetLoadedCellCount() const;
+
+        // cells being read, restored or written
+        size_t GetPendingCellCount() const;
+
+    private:
+        enum class ECellState : uint8_t
+        {
+            Loaded,
+            Reading,
+            Restoring,
+            Writing,
+            Unloaded
+        };
+
+        struct ACell
+        {
+            int X = 0;
+            int Y = 0;
+            ECellState State = ECellState::Loaded;
+
+            std::unique_ptr<AWorldSnapshotLoader> Loader;
+
+            // result of the background read or write, declared after Loader so it's
+            // destroyed (and waited on) before the loader the read writes to
+            std::future<bool> Io;
+        };
+
+        static int64_t GetCellKey(int x, int y);
+
+        std::string GetCellPath(int x, int y) const;
+
+        int GetCellIndex(float position) const;
+
+        ACell &GetCell(int x, int y);
+
+        // everything below runs at the sync point
+        void ProcessSyncPoint(AWorld *world);
+
+        void PollIo();
+
+        void RequestLoads(int cameraX, int cameraY);
+
+        // returns false when it ran out of budget
+        bool UnloadCells(AWorld *world, int cameraX, int cameraY, std::chrono::steady_clock::time_point start);
+
+        void RestoreCells(AWorld *world, std::chrono::steady_clock::time_point start);
+
+        std::unordered_map<int64_t, ACell> Cells;
+
+        int CameraCellX = 0;
+        int CameraCellY = 0;
+        bool HasCameraCell = false;
+
+        // the camera changed cells and the unload pass hasn't finished since
+        bool UnloadPending = false;
+        size_t UnloadScanIndex = 0;
+        std::unordered_map<int64_t, std::vector<AEntity *>> UnloadBuckets;
+
+        bool SyncQueued = false;
+
+        // sync point callbacks check this, the system may be gone by the time they run
+        std::shared_ptr<bool> AliveToken = std::make_shared<bool>(true);
+    };
+}
+
+#endif // ATLANTIS_ENGINE_WORLDPARTITION_H
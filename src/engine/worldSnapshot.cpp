@@ -0,0 +1,953 @@
+#include "engine/worldSnapshot.h"
+#include "engine/compression.h"
+#include "engine/core.h"
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+
+namespace Atlantis
+{
+    namespace
+    {
+        enum class ERecord : uint8_t
+        {
+            End,
+            Type,
+            Entity
+        };
+
+        using ASnapshotSink = std::function<bool(const uint8_t *data, size_t size)>;
+
+        // buffers the body and hands it to the sink in blocks, compressed if asked to
+        struct ASnapshotWriter
+        {
+            ASnapshotSink Sink;
+            bool Compressed = false;
+            bool Failed = false;
+
+            std::vector<uint8_t> Buffer;
+            std::vector<uint8_t> CompressedBuffer;
+
+            void WriteBytes(const void *data, size_t size)
+            {
+                const uint8_t *bytes = static_cast<const uint8_t *>(data);
+                Buffer.insert(Buffer.end(), bytes, bytes + size);
+
+                if (Buffer.size() >= AWorldSnapshot::BlockSize)
+                {
+                    Flush();
+                }
+            }
+
+            template <typename T>
+            void Write(const T &value)
+            {
+                WriteBytes(&value, sizeof(T));
+            }
+
+            void WriteString(const std::string &str)
+            {
+                Write<uint32_t>(str.size());
+                WriteBytes(str.data(), str.size());
+            }
+
+            void Flush()
+            {
+                if (!Compressed)
+                {
+                    Emit(Buffer.data(), Buffer.size());
+                    Buffer.clear();
+                    return;
+                }
+
+                // blocks never span more than BlockSize, the reader relies on it
+                size_t pos = 0;
+                while (pos < Buffer.size())
+                {
+                    size_t rawSize = std::min(Buffer.size() - pos, AWorldSnapshot::BlockSize);
+                    EmitBlock(Buffer.data() + pos, rawSize);
+                    pos += rawSize;
+                }
+                Buffer.clear();
+            }
+
+            void Finish()
+            {
+                Flush();
+
+                if (Compressed)
+                {
+                    uint32_t end[2] = {0, 0};
+                    Emit(end, sizeof(end));
+                }
+            }
+
+        private:
+            void Emit(const void *data, size_t size)
+            {
+                if (!Failed && size > 0 && !Sink(static_cast<const uint8_t *>(data), size))
+                {
+                    Failed = true;
+                }
+            }
+
+            void EmitBlock(const uint8_t *data, size_t rawSize)
+            {
+                CompressedBuffer.resize(ACompression::CompressBound(rawSize));
+                size_t compressedSize = ACompression::Compress(data, rawSize, CompressedBuffer.data());
+
+                // incompressible blocks are stored as is
+                bool store = compressedSize >= rawSize;
+                uint32_t header[2] = {(uint32_t)rawSize, (uint32_t)(store ? rawSize : compressedSize)};
+
+                Emit(header, sizeof(header));
+                Emit(store ? data : CompressedBuffer.data(), header[1]);
+            }
+        };
+
+        struct ASnapshotReader
+        {
+            const uint8_t *Data;
+            size_t Size;
+            size_t Pos = 0;
+            bool Failed = false;
+
+            const uint8_t *Take(size_t size)
+            {
+                if (Failed || Pos + size > Size)
+                {
+                    Failed = true;
+                    return nullptr;
+                }
+
+                const uint8_t *ptr = Data + Pos;
+                Pos += size;
+                return ptr;
+            }
+
+            template <typename T>
+            T Read()
+            {
+                T value{};
+                if (const uint8_t *ptr = Take(sizeof(T)))
+                {
+                    memcpy(&value, ptr, sizeof(T));
+                }
+                return value;
+            }
+
+            std::string ReadString()
+            {
+                uint32_t size = Read<uint32_t>();
+                const uint8_t *ptr = Take(size);
+
+                return ptr != nullptr ? std::string((const char *)ptr, size) : std::string();
+            }
+        };
+
+        // fallback for generated headers that predate APropertyData::Size
+        size_t GetKindSize(EPropertyKind kind)
+        {
+            switch (kind)
+            {
+            case EPropertyKind::Bool:
+                return sizeof(bool);
+            case EPropertyKind::Int:
+                return sizeof(int);
+            case EPropertyKind::Float:
+                return sizeof(float);
+            case EPropertyKind::Double:
+                return sizeof(double);
+            case EPropertyKind::Color:
+                return sizeof(Color);
+            case EPropertyKind::Texture2D:
+                return sizeof(Texture2D);
+            default:
+                return 0;
+            }
+        }
+
+        bool IsPropertyEqual(EPropertyKind kind, size_t size, const void *l, const void *r)
+        {
+            switch (kind)
+            {
+            case EPropertyKind::String:
+                return *static_cast<const std::string *>(l) == *static_cast<const std::string *>(r);
+            case EPropertyKind::Name:
+                return *static_cast<const AName *>(l) == *static_cast<const AName *>(r);
+            case EPropertyKind::ResourceHandle:
+                return *static_cast<const AResourceHandle *>(l) == *static_cast<const AResourceHandle *>(r);
+            case EPropertyKind::Unknown:
+                return true;
+            default:
+                return memcmp(l, r, size) == 0;
+            }
+        }
+
+        void CopyProperty(EPropertyKind kind, size_t size, void *dst, const void *src)
+        {
+            switch (kind)
+            {
+            case EPropertyKind::String:
+                *static_cast<std::string *>(dst) = *static_cast<const std::string *>(src);
+                break;
+            case EPropertyKind::Name:
+                *static_cast<AName *>(dst) = *static_cast<const AName *>(src);
+                break;
+            case EPropertyKind::ResourceHandle:
+                *static_cast<AResourceHandle *>(dst) = *static_cast<const AResourceHandle *>(src);
+                break;
+            case EPropertyKind::Unknown:
+                break;
+            default:
+                memcpy(dst, src, size);
+                break;
+            }
+        }
+
+        struct ATypeInfo
+        {
+            AName Name;
+            const AObject *CDO = nullptr;
+            std::vector<APropertyData> Properties;
+            std::vector<EPropertyKind> Kinds;
+        };
+
+        struct ASnapshotCapture
+        {
+            AWorld *World;
+            uint32_t Flags;
+            ASnapshotWriter &Writer;
+
+            std::vector<ATypeInfo> Types;
+            std::vector<uint8_t> Mask;
+
+            uint32_t GetTypeIndex(const AClassData &classData)
+            {
+                // there's only a handful of types, a linear scan over the hashes is fine
+                for (uint32_t i = 0; i < Types.size(); i++)
+                {
+                    if (Types[i].Name == classData.Name)
+                    {
+                        return i;
+                    }
+                }
+
+                ATypeInfo type;
+                type.Name = classData.Name;
+                type.CDO = World->GetCDO<AObject>(classData.Name);
+                type.Properties = classData.Properties;
+
+                for (APropertyData &prop : type.Properties)
+                {
+                    EPropertyKind kind = prop.GetKind();
+                    type.Kinds.push_back(kind);
+
+                    if (!IsTriviallyCopyable(kind))
+                    {
+                        prop.Size = 0;
+                    }
+                    else if (prop.Size == 0)
+                    {
+                        prop.Size = GetKindSize(kind);
+                    }
+                }
+
+                Writer.Write(ERecord::Type);
+                Writer.WriteString(type.Name.GetName());
+                Writer.Write<uint32_t>(type.Properties.size());
+
+                for (size_t i = 0; i < type.Properties.size(); i++)
+                {
+                    Writer.WriteString(type.Properties[i].Name.GetName());
+                    Writer.WriteString(type.Properties[i].Type.GetName());
+                    Writer.Write<uint8_t>((uint8_t)type.Kinds[i]);
+                    Writer.Write<uint32_t>(type.Properties[i].Size);
+                }
+
+                Types.push_back(type);
+                return Types.size() - 1;
+            }
+
+            void WriteObject(const AObject *object, const ATypeInfo &type)
+            {
+                bool delta = (Flags & AWorldSnapshot::FlagDelta) && type.CDO != nullptr;
+
+                if (delta)
+                {
+                    Mask.assign((type.Properties.size() + 7) / 8, 0);
+                    for (size_t i = 0; i < type.Properties.size(); i++)
+                    {
+                        const APropertyData &prop = type.Properties[i];
+                        const void *value = (const void *)((size_t)object + prop.Offset);
+                        const void *defaultValue = (const void *)((size_t)type.CDO + prop.Offset);
+
+                        if (!IsPropertyEqual(type.Kinds[i], prop.Size, value, defaultValue))
+                        {
+                            Mask[i / 8] |= 1 << (i % 8);
+                        }
+                    }
+
+                    Writer.WriteBytes(Mask.data(), Mask.size());
+                }
+
+                for (size_t i = 0; i < type.Properties.size(); i++)
+                {
+                    if (delta && !(Mask[i / 8] & (1 << (i % 8))))
+                    {
+                        continue;
+                    }
+
+                    const APropertyData &prop = type.Properties[i];
+                    const void *src = (const void *)((size_t)object + prop.Offset);
+
+                    switch (type.Kinds[i])
+                    {
+                    case EPropertyKind::String:
+                        Writer.WriteString(*static_cast<const std::string *>(src));
+                        break;
+                    case EPropertyKind::Name:
+                    {
+                        const AName &name = *static_cast<const AName *>(src);
+                        Writer.WriteString(name.Name.empty() ? std::string() : name.GetName());
+                        break;
+                    }
+                    case EPropertyKind::ResourceHandle:
+                    {
+                        const AResourceHandle &handle = *static_cast<const AResourceHandle *>(src);
+                        Writer.WriteString(handle.IsValid() ? handle.ResourceHolder->GetResourcePath(handle.Id) : std::string());
+                        break;
+                    }
+                    case EPropertyKind::Unknown:
+                        break;
+                    default:
+                        Writer.WriteBytes(src, prop.Size);
+                        break;
+                    }
+                }
+            }
+
+            void WriteEntity(AEntity *entity)
+            {
+                // type records have to come before the entity record that uses them
+                uint32_t entityType = GetTypeIndex(entity->GetClassData());
+                for (AComponent *component : entity->Components)
+                {
+                    GetTypeIndex(component->GetClassData());
+                }
+
+                Writer.Write(ERecord::Entity);
+                Writer.Write(entityType);
+                WriteObject(entity, Types[entityType]);
+
+                Writer.Write<uint32_t>(entity->Components.size());
+                for (AComponent *component : entity->Components)
+                {
+                    uint32_t typeIndex = GetTypeIndex(component->GetClassData());
+                    Writer.Write(typeIndex);
+                    WriteObject(component, Types[typeIndex]);
+                }
+            }
+
+            // all alive entities if entities is null
+            void WriteWorld(const std::vector<AEntity *> *entities)
+            {
+                if (entities != nullptr)
+                {
+                    for (AEntity *entity : *entities)
+                    {
+                        WriteEntity(entity);
+                    }
+                }
+                else
+                {
+                    for (const auto &entityObj : World->GetObjectsByName("AEntity"))
+                    {
+                        if (entityObj->_isAlive)
+                        {
+                            WriteEntity(static_cast<AEntity *>(entityObj.get()));
+                        }
+                    }
+                }
+
+                Writer.Write(ERecord::End);
+                Writer.Finish();
+            }
+        };
+
+        bool WriteSnapshot(AWorld *world, const std::vector<AEntity *> *entities, uint32_t flags, const ASnapshotSink &sink)
+        {
+            uint32_t header[3] = {AWorldSnapshot::Magic, AWorldSnapshot::FormatVersion, flags};
+            if (!sink((const uint8_t *)header, sizeof(header)))
+            {
+                return false;
+            }
+
+            ASnapshotWriter writer{sink, (flags & AWorldSnapshot::FlagCompressed) != 0};
+            ASnapshotCapture capture{world, flags, writer};
+            capture.WriteWorld(entities);
+
+            return !writer.Failed;
+        }
+
+        bool DecompressBody(ASnapshotReader &reader, std::vector<uint8_t> &body)
+        {
+            while (!reader.Failed)
+            {
+                uint32_t rawSize = reader.Read<uint32_t>();
+                uint32_t storedSize = reader.Read<uint32_t>();
+
+                if (rawSize == 0)
+                {
+                    return !reader.Failed;
+                }
+
+                const uint8_t *src = reader.Take(storedSize);
+                if (src == nullptr || rawSize > AWorldSnapshot::BlockSize)
+                {
+                    return false;
+                }
+
+                size_t pos = body.size();
+                body.resize(pos + rawSize);
+
+                if (storedSize == rawSize)
+                {
+                    memcpy(body.data() + pos, src, rawSize);
+                }
+                else if (!ACompression::Decompress(src, storedSize, body.data() + pos, rawSize))
+                {
+                    return false;
+                }
+            }
+
+            return false;
+        }
+
+        void ReadObject(ASnapshotReader &reader, AWorld *world, AObject *object, const ASnapshotRestoreType &type, bool delta)
+        {
+            const uint8_t *mask = delta ? reader.Take((type.Properties.size() + 7) / 8) : nullptr;
+            if (delta && mask == nullptr)
+            {
+                return;
+            }
+
+            for (size_t i = 0; i < type.Properties.size(); i++)
+            {
+                const ASnapshotRestoreProperty &prop = type.Properties[i];
+                void *dst = (object != nullptr && prop.Exists) ? (void *)((size_t)object + prop.Offset) : nullptr;
+
+                // objects reused from the dead list still hold their old values
+                if (mask != nullptr && !(mask[i / 8] & (1 << (i % 8))))
+                {
+                    if (dst != nullptr && type.CDO != nullptr)
+                    {
+                        CopyProperty(prop.Kind, prop.Size, dst, (const void *)((size_t)type.CDO + prop.Offset));
+                    }
+                    continue;
+                }
+
+                switch (prop.Kind)
+                {
+                case EPropertyKind::String:
+                {
+                    std::string str = reader.ReadString();
+                    if (dst != nullptr)
+                    {
+                        *static_cast<std::string *>(dst) = str;
+                    }
+                    break;
+                }
+                case EPropertyKind::Name:
+                {
+                    std::string str = reader.ReadString();
+                    if (dst != nullptr)
+                    {
+                        *static_cast<AName *>(dst) = str.empty() ? AName::None() : AName(str);
+                    }
+                    break;
+                }
+                case EPropertyKind::ResourceHandle:
+                {
+                    std::string path = reader.ReadString();
+                    if (dst != nullptr)
+                    {
+                        *static_cast<AResourceHandle *>(dst) = path.empty() ? AResourceHandle() : world->ResourceHolder.GetTexture(path);
+                    }
+                    break;
+                }
+                case EPropertyKind::Unknown:
+                    break;
+                default:
+                {
+                    const uint8_t *src = reader.Take(prop.Size);
+                    if (dst != nullptr && src != nullptr)
+                    {
+                        memcpy(dst, src, prop.Size);
+                    }
+                    break;
+                }
+                }
+            }
+        }
+
+        // maps a type record onto the current layout
+        void ReadType(ASnapshotReader &reader, AWorld *world, ASnapshotRestoreType &type)
+        {
+            type.Name = reader.ReadString();
+            type.Exists = world->CDOs.contains(type.Name);
+            type.Properties.resize(reader.Read<uint32_t>());
+
+            const AClassData *classData = type.Exists ? world->CData[type.Name] : nullptr;
+            type.CDO = type.Exists ? world->CDOs[type.Name].get() : nullptr;
+
+            for (ASnapshotRestoreProperty &prop : type.Properties)
+            {
+                AName name = reader.ReadString();
+                AName propType = reader.ReadString();
+                prop.Kind = (EPropertyKind)reader.Read<uint8_t>();
+                prop.Size = reader.Read<uint32_t>();
+
+                if (classData == nullptr || reader.Failed)
+                {
+                    continue;
+                }
+
+                const APropertyData *current = classData->FindProperty(name);
+                if (current != nullptr && current->Type == propType && (!IsTriviallyCopyable(prop.Kind) || current->Size == 0 || current->Size == prop.Size))
+                {
+                    prop.Exists = true;
+                    prop.Offset = current->Offset;
+                }
+            }
+        }
+    }
+
+    void AWorldSnapshot::Capture(AWorld *world, uint32_t flags)
+    {
+        Clear();
+        Data.reserve(world->GetObjectsByName("AEntity").size() * 128);
+
+        WriteSnapshot(world, nullptr, flags, [this](const uint8_t *data, size_t size)
+                      {
+                          Data.insert(Data.end(), data, data + size);
+                          return true; });
+    }
+
+    void AWorldSnapshot::Capture(AWorld *world, const std::vector<AEntity *> &entities, uint32_t flags)
+    {
+        Clear();
+        Data.reserve(entities.size() * 128);
+
+        WriteSnapshot(world, &entities, flags, [this](const uint8_t *data, size_t size)
+                      {
+                          Data.insert(Data.end(), data, data + size);
+                          return true; });
+    }
+
+    bool AWorldSnapshot::Save(AWorld *world, const std::string &path, uint32_t flags)
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+        {
+            std::cout << "AWorldSnapshot::Save | Error: Could not open " << path << std::endl;
+            return false;
+        }
+
+        bool ok = WriteSnapshot(world, nullptr, flags, [&file](const uint8_t *data, size_t size)
+                                {
+                                    file.write((const char *)data, size);
+                                    return file.good(); });
+
+        if (!ok)
+        {
+            std::cout << "AWorldSnapshot::Save | Error: Failed writing " << path << std::endl;
+        }
+
+        return ok;
+    }
+
+    bool AWorldSnapshot::Load(const std::string &path)
+    {
+        Clear();
+
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file.is_open())
+        {
+            std::cout << "AWorldSnapshot::Load | Error: Could not open " << path << std::endl;
+            return false;
+        }
+
+        Data.resize(file.tellg());
+        file.seekg(0);
+        file.read((char *)Data.data(), Data.size());
+
+        return file.good();
+    }
+
+    bool AWorldSnapshot::Restore(AWorld *world) const
+    {
+        AWorldSnapshotLoader loader;
+
+        return loader.BeginView(Data.data(), Data.size()) && loader.Step(world, 0.0f) && !loader.IsFailed();
+    }
+
+    bool AWorldSnapshot::Write(const std::string &path, bool compress) const
+    {
+        ASnapshotReader reader{Data.data(), Data.size()};
+        uint32_t header[3] = {reader.Read<uint32_t>(), reader.Read<uint32_t>(), reader.Read<uint32_t>()};
+
+        if (reader.Failed || header[0] != Magic)
+        {
+            std::cout << "AWorldSnapshot::Write | Error: Not a world snapshot" << std::endl;
+            return false;
+        }
+
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+        {
+            std::cout << "AWorldSnapshot::Write | Error: Could not open " << path << std::endl;
+            return false;
+        }
+
+        if (!compress || (header[2] & FlagCompressed))
+        {
+            file.write((const char *)Data.data(), Data.size());
+            return file.good();
+        }
+
+        header[2] |= FlagCompressed;
+        file.write((const char *)header, sizeof(header));
+
+        ASnapshotWriter writer{[&file](const uint8_t *data, size_t size)
+                               {
+                                   file.write((const char *)data, size);
+                                   return file.good(); },
+                               true};
+
+        for (size_t pos = reader.Pos; pos < Data.size(); pos += BlockSize)
+        {
+            writer.WriteBytes(Data.data() + pos, std::min(BlockSize, Data.size() - pos));
+        }
+        writer.Finish();
+
+        return !writer.Failed && file.good();
+    }
+
+    size_t AWorldSnapshot::GetSize() const
+    {
+        return Data.size();
+    }
+
+    bool AWorldSnapshot::IsEmpty() const
+    {
+        return Data.empty();
+    }
+
+    void AWorldSnapshot::Clear()
+    {
+        std::vector<uint8_t>().swap(Data);
+    }
+
+    bool AWorldSnapshotLoader::Begin(std::vector<uint8_t> &&data)
+    {
+        Clear();
+        Source = std::move(data);
+
+        return BeginView(Source.data(), Source.size());
+    }
+
+    bool AWorldSnapshotLoader::BeginView(const uint8_t *data, size_t size)
+    {
+        ASnapshotReader reader{data, size};
+
+        if (reader.Read<uint32_t>() != AWorldSnapshot::Magic)
+        {
+            std::cout << "AWorldSnapshotLoader::Begin | Error: Not a world snapshot" << std::endl;
+            Failed = true;
+            return false;
+        }
+
+        uint32_t version = reader.Read<uint32_t>();
+        if (version != AWorldSnapshot::FormatVersion)
+        {
+            std::cout << "AWorldSnapshotLoader::Begin | Error: Unsupported format version " << version << std::endl;
+            Failed = true;
+            return false;
+        }
+
+        uint32_t flags = reader.Read<uint32_t>();
+        Delta = (flags & AWorldSnapshot::FlagDelta) != 0;
+
+        if (flags & AWorldSnapshot::FlagCompressed)
+        {
+            if (!DecompressBody(reader, Body))
+            {
+                std::cout << "AWorldSnapshotLoader::Begin | Error: Snapshot is truncated or corrupt" << std::endl;
+                Failed = true;
+                return false;
+            }
+
+            // the compressed data isn't needed anymore
+            std::vector<uint8_t>().swap(Source);
+
+            BodyData = Body.data();
+            BodySize = Body.size();
+        }
+        else
+        {
+            BodyData = data + reader.Pos;
+            BodySize = size - reader.Pos;
+        }
+
+        return !reader.Failed;
+    }
+
+    bool AWorldSnapshotLoader::Step(AWorld *world, float budgetMs)
+    {
+        if (Done || Failed)
+        {
+            return true;
+        }
+
+        ASnapshotReader reader{BodyData, BodySize, Pos};
+        auto start = std::chrono::steady_clock::now();
+        size_t entitiesRestored = 0;
+
+        while (!reader.Failed && !Done)
+        {
+            // checking the clock for every entity would cost more than the entity
+            if (budgetMs > 0.0f && ++entitiesRestored % 64 == 0 &&
+                std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count() >= budgetMs)
+            {
+                break;
+            }
+
+            switch (reader.Read<ERecord>())
+            {
+            case ERecord::End:
+                Done = true;
+                break;
+            case ERecord::Type:
+                Types.emplace_back();
+                ReadType(reader, world, Types.back());
+                break;
+            case ERecord::Entity:
+            {
+                uint32_t typeIndex = reader.Read<uint32_t>();
+                if (typeIndex >= Types.size())
+                {
+                    reader.Failed = true;
+                    break;
+                }
+
+                const ASnapshotRestoreType &entityType = Types[typeIndex];
+                AEntity *entity = entityType.Exists ? world->NewObject_Internal<AEntity>(entityType.Name) : nullptr;
+                ReadObject(reader, world, entity, entityType, Delta);
+
+                uint32_t componentCount = reader.Read<uint32_t>();
+                for (uint32_t c = 0; c < componentCount && !reader.Failed; c++)
+                {
+                    typeIndex = reader.Read<uint32_t>();
+                    if (typeIndex >= Types.size())
+                    {
+                        reader.Failed = true;
+                        break;
+                    }
+
+                    const ASnapshotRestoreType &componentType = Types[typeIndex];
+                    AComponent *component = (entity != nullptr && componentType.Exists) ? world->NewObject_Internal<AComponent>(componentType.Name) : nullptr;
+                    ReadObject(reader, world, component, componentType, Delta);
+
+                    if (component != nullptr)
+                    {
+                        entity->AddComponent(component);
+                    }
+                }
+                break;
+            }
+            default:
+                reader.Failed = true;
+                break;
+            }
+        }
+
+        Pos = reader.Pos;
+
+        if (reader.Failed)
+        {
+            std::cout << "AWorldSnapshotLoader::Step | Error: Snapshot is truncated or corrupt" << std::endl;
+            Failed = true;
+        }
+
+        return Done || Failed;
+    }
+
+    bool AWorldSnapshotLoader::IsFailed() const
+    {
+        return Failed;
+    }
+
+    float AWorldSnapshotLoader::GetProgress() const
+    {
+        return Done ? 1.0f : BodySize > 0 ? (float)Pos / BodySize : 0.0f;
+    }
+
+    void AWorldSnapshotLoader::Clear()
+    {
+        std::vector<uint8_t>().swap(Source);
+        std::vector<uint8_t>().swap(Body);
+        BodyData = nullptr;
+        BodySize = 0;
+        Pos = 0;
+        Delta = false;
+        Failed = false;
+        Done = false;
+        Types.clear();
+    }
+
+    AWorldSnapshotStreamer::~AWorldSnapshotStreamer()
+    {
+        if (SaveThread.joinable())
+        {
+            SaveThread.join();
+        }
+
+        if (LoadThread.joinable())
+        {
+            LoadThread.join();
+        }
+    }
+
+    bool AWorldSnapshotStreamer::RequestSave(AWorld *world, const std::string &path)
+    {
+        if (Saving)
+        {
+            return false;
+        }
+
+        Saving = true;
+
+        if (SaveThread.joinable())
+        {
+            SaveThread.join();
+        }
+
+        world->QueueSyncPoint([this, world, path]()
+                              {
+            auto start = std::chrono::steady_clock::now();
+            SaveSnapshot.Capture(world, AWorldSnapshot::FlagDelta);
+            auto end = std::chrono::steady_clock::now();
+
+            std::cout << "Captured world for saving, " << SaveSnapshot.GetSize() << " bytes in "
+                      << std::chrono::duration<float, std::milli>(end - start).count() << "ms" << std::endl;
+
+            SaveThread = std::thread([this, path]()
+                                     {
+                AProfiler::SetThreadName("Save");
+
+                if (SaveSnapshot.Write(path))
+                {
+                    std::cout << "Saved world to " << path << std::endl;
+                }
+
+                SaveSnapshot.Clear();
+                Saving = false; }); });
+
+        return true;
+    }
+
+    bool AWorldSnapshotStreamer::RequestLoad(const std::string &path, bool replaceWorld)
+    {
+        if (Loading)
+        {
+            return false;
+        }
+
+        Loading = true;
+        LoadReading = true;
+        LoadReadFailed = false;
+        ReplaceWorld = replaceWorld;
+        ReplaceIndex = 0;
+        LoadPath = path;
+
+        if (LoadThread.joinable())
+        {
+            LoadThread.join();
+        }
+
+        LoadThread = std::thread([this]()
+                                 {
+            AProfiler::SetThreadName("Load");
+
+            AWorldSnapshot snapshot;
+            LoadReadFailed = !snapshot.Load(LoadPath) || !Loader.Begin(std::move(snapshot.Data));
+            LoadReading = false; });
+
+        return true;
+    }
+
+    void AWorldSnapshotStreamer::Update(AWorld *world)
+    {
+        if (!Loading || LoadReading || LoadStepQueued)
+        {
+            return;
+        }
+
+        if (LoadReadFailed)
+        {
+            std::cout << "AWorldSnapshotStreamer::Update | Error: Could not load " << LoadPath << std::endl;
+            Loader.Clear();
+            Loading = false;
+            return;
+        }
+
+        LoadStepQueued = true;
+        world->QueueSyncPoint([this, world]()
+                              {
+            LoadStepQueued = false;
+
+            // the old entities go first, spread over frames like the load itself
+            if (ReplaceWorld)
+            {
+                const auto &entities = world->GetObjectsByName("AEntity");
+                auto start = std::chrono::steady_clock::now();
+
+                while (ReplaceIndex < entities.size())
+                {
+                    // kills the components along with the entity
+                    if (entities[ReplaceIndex]->_isAlive)
+                    {
+                        entities[ReplaceIndex]->MarkObjectDead();
+                    }
+
+                    if (++ReplaceIndex % 256 == 0 &&
+                        std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count() >= LoadBudgetMs)
+                    {
+                        return;
+                    }
+                }
+
+                ReplaceWorld = false;
+            }
+
+            if (Loader.Step(world, LoadBudgetMs))
+            {
+                std::cout << (Loader.IsFailed() ? "Failed loading world from " : "Loaded world from ") << LoadPath << std::endl;
+                Loader.Clear();
+                Loading = false;
+            } });
+    }
+
+    bool AWorldSnapshotStreamer::IsSaving() const
+    {
+        return Saving;
+    }
+
+    bool AWorldSnapshotStreamer::IsLoading() const
+    {
+        return Loading;
+    }
+}
@@ -0,0 +1,175 @@
+#ifndef ATLANTIS_ENGINE_WORLDSNAPSHOT_H
+#define ATLANTIS_ENGINE_WORLDSNAPSHOT_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+#include "engine/reflection/reflectionHelpers.h"
+
+namespace Atlantis
+{
+    struct AWorld;
+    struct AObject;
+    struct AEntity;
+
+    // binary copy of all alive entities and their components
+    //
+    // layout:
+    //   header   magic, format version, flags
+    //   body     stream of records, each starting with a record type byte
+    //            type    name, property count, per property: name, type, kind, size
+    //            entity  type index, properties, component count,
+    //                    per component: type index, properties
+    //            end
+    //
+    // types are written the first time an entity uses them, so the body can be
+    // streamed out while walking the world
+    // properties are written in type table order, trivially copyable ones as raw
+    // bytes, strings / names / resource paths length prefixed
+    // with FlagDelta every object starts with a bitmask of the properties that differ
+    // from the CDO and only those are written
+    // with FlagCompressed the body is split into blocks of up to BlockSize bytes,
+    // each stored as raw size, stored size and the ACompression output
+    //
+    // restoring matches properties by name and type against the current AClassData,
+    // so it survives reordered, added or removed properties
+    struct AWorldSnapshot
+    {
+        static constexpr uint32_t Magic = 0x504e5341; // "ASNP"
+        static constexpr uint32_t FormatVersion = 2;
+
+        static constexpr uint32_t FlagDelta = 1 << 0;
+        static constexpr uint32_t FlagCompressed = 1 << 1;
+
+        static constexpr size_t BlockSize = 64 * 1024;
+
+        std::vector<uint8_t> Data;
+
+        // writes every property by default, with FlagDelta the file depends on the
+        // CDOs it gets loaded with
+        void Capture(AWorld *world, uint32_t flags = 0);
+
+        // only the given entities, they have to be alive
+        void Capture(AWorld *world, const std::vector<AEntity *> &entities, uint32_t flags = 0);
+
+        // recreates the entities in the world, types have to be registered already
+        bool Restore(AWorld *world) const;
+
+        // writes the world straight to disk without building the snapshot in memory first
+        static bool Save(AWorld *world, const std::string &path, uint32_t flags = FlagDelta | FlagCompressed);
+
+        // writes the captured data to disk, compressing it on the way if it isn't yet
+        bool Write(const std::string &path, bool compress = true) const;
+
+        bool Load(const std::string &path);
+
+        size_t GetSize() const;
+
+        bool IsEmpty() const;
+
+        void Clear();
+    };
+
+    // a type record of a snapshot mapped onto the current layout
+    struct ASnapshotRestoreProperty
+    {
+        EPropertyKind Kind = EPropertyKind::Unknown;
+        uint32_t Size = 0;
+
+        // offset in the current layout, properties that are gone get skipped
+        bool Exists = false;
+        size_t Offset = 0;
+    };
+
+    struct ASnapshotRestoreType
+    {
+        AName Name;
+        bool Exists = false;
+        const AObject *CDO = nullptr;
+        std::vector<ASnapshotRestoreProperty> Properties;
+    };
+
+    // restores a snapshot a slice at a time, AWorldSnapshot::Restore runs it in one go
+    struct AWorldSnapshotLoader
+    {
+        // checks the header and decompresses, doesn't touch the world so it can run
+        // on a background thread
+        bool Begin(std::vector<uint8_t> &&data);
+
+        // restores entities until budgetMs is used up, a budget of 0 means no limit
+        // returns true once the snapshot is fully restored or failed
+        bool Step(AWorld *world, float budgetMs);
+
+        bool IsFailed() const;
+
+        // share of the snapshot restored so far
+        float GetProgress() const;
+
+        void Clear();
+
+    private:
+        friend struct AWorldSnapshot;
+
+        // restores from data owned by someone else, it has to outlive the loader
+        bool BeginView(const uint8_t *data, size_t size);
+
+        std::vector<uint8_t> Source;
+        std::vector<uint8_t> Body;
+
+        const uint8_t *BodyData = nullptr;
+        size_t BodySize = 0;
+        size_t Pos = 0;
+
+        bool Delta = false;
+        bool Failed = false;
+        bool Done = false;
+
+        std::vector<ASnapshotRestoreType> Types;
+    };
+
+    // saves and loads snapshots without stalling the main loop
+    //
+    // a save copies the world at the next sync point in SyncEntities, the only time
+    // neither thread touches components, then compresses and writes it on a
+    // background thread
+    // a load reads and decompresses the file on a background thread, then restores
+    // LoadBudgetMs worth of entities at each of the following sync points
+    struct AWorldSnapshotStreamer
+    {
+        float LoadBudgetMs = 2.0f;
+
+        ~AWorldSnapshotStreamer();
+
+        // returns false while the previous save is still in flight
+        bool RequestSave(AWorld *world, const std::string &path);
+
+        // replaceWorld kills all entities before restoring the first one
+        bool RequestLoad(const std::string &path, bool replaceWorld = true);
+
+        // main thread, once per frame before ProcessSystems
+        void Update(AWorld *world);
+
+        bool IsSaving() const;
+
+        bool IsLoading() const;
+
+    private:
+        std::thread SaveThread;
+        std::atomic<bool> Saving = false;
+        AWorldSnapshot SaveSnapshot;
+
+        std::thread LoadThread;
+        std::atomic<bool> LoadReading = false;
+        std::atomic<bool> LoadReadFailed = false;
+        bool Loading = false;
+        bool LoadStepQueued = false;
+        bool ReplaceWorld = false;
+        size_t ReplaceIndex = 0;
+        AWorldSnapshotLoader Loader;
+        std::string LoadPath;
+    };
+}
+
+#endif // ATLANTIS_ENGINE_WORLDSNAPSHOT_H
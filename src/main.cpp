@@ -33,6 +33,9 @@ typedef struct tagMSG *LPMSG; // All USER defines and routines
 
 #include "helpers.h"
 #include "engine/profiling.h"
+#include "engine/worldSnapshot.h"
+#include "engine/worldPartition.h"
+#include "engine/fileWatcher.h"
 #include "engine/scripting/luaRuntime.h"
 
 using namespace Atlantis;
@@ -47,8 +50,8 @@ std::string LibDir;
 std::string FinalLibName = "";
 std::string DirSlash = "/";
 
-std::function<bool()> HotReloadTimer = []()
-{ return false; };
+// set once the game lib's file settled after a change
+bool HotReloadRequested = false;
 
 std::string LibTempName = "";
 
@@ -62,6 +65,10 @@ void TryUnloadGameLib();
 void PreHotReload();
 void PostHotReload();
 
+// game lib, lua scripts and assets
+AFileWatcher FileWatcher;
+void StartFileWatcher();
+
 // engine modules
 AWorld World;
 
@@ -69,6 +76,11 @@ ALuaRuntime LuaRuntime;
 
 std::atomic<bool> ExitSignal = false;
 
+// F5 / F6, polled on the render thread
+AWorldSnapshotStreamer SnapshotStreamer;
+std::atomic<bool> QuickSaveRequested = false;
+std::atomic<bool> QuickLoadRequested = false;
+
 void RegisterTypes()
 {
     World.RegisterDefault<AEntity>();
@@ -77,6 +89,7 @@ void RegisterTypes()
     World.RegisterDefault<CVelocity>();
     World.RegisterDefault<CRenderable>();
     World.RegisterDefault<CCamera>();
+    World.RegisterDefault<CPartitioned>();
 
     if (!LibTempName.empty() && LibPtr != nullptr)
     {
@@ -106,22 +119,49 @@ void RegisterSystems()
     World.RegisterSystem(World.ProfilerRenderThread, {"EndRender", "Render"});
 }
 
+void ParseCommandLine(int argc, char **argv);
 void DoMain();
 
+// --trace <file>: capture a profile from startup until exit
+std::string TraceCapturePath = "";
+
+// --lua-profile: sample lua systems from startup, F10 toggles it
+bool LuaProfileOnStart = false;
+std::atomic<bool> LuaProfileToggleRequested = false;
+
 #if defined(_WIN32)
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, char *pCmdLine, int nCmdShow)
 {
+    ParseCommandLine(__argc, __argv);
     DoMain();
     return 0;
 }
 #endif
 
-int main()
+int main(int argc, char **argv)
 {
+    ParseCommandLine(argc, argv);
     DoMain();
     return 0;
 }
 
+void ParseCommandLine(int argc, char **argv)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+
+        if (arg == "--trace" && i + 1 < argc)
+        {
+            TraceCapturePath = argv[++i];
+        }
+        else if (arg == "--lua-profile")
+        {
+            LuaProfileOnStart = true;
+        }
+    }
+}
+
 void DoMain()
 {
     auto cpuThreadCount = omp_get_num_procs();
@@ -146,6 +186,13 @@ void DoMain()
 
     omp_set_num_threads(cpuThreadCount);
 
+    AProfiler::SetThreadName("Main");
+
+    if (!TraceCapturePath.empty())
+    {
+        AProfiler::BeginCapture(TraceCapturePath);
+    }
+
     std::ifstream projectFile("./project.aeng");
     std::getline(projectFile, LibName);
 
@@ -156,13 +203,29 @@ void DoMain()
     // start render thread for raylib
     std::thread RenderThread([]()
                              {
+        AProfiler::SetThreadName("Render");
         InitWindow(screenWidth, screenHeight, "AtlantisEngine");
         //SetTargetFPS(120);
         while (!WindowShouldClose())
         {
             World.ProcessSystemsRenderThread(); 
+
+            if (IsKeyPressed(KEY_F5))
+            {
+                QuickSaveRequested = true;
+            }
+
+            if (IsKeyPressed(KEY_F6))
+            {
+                QuickLoadRequested = true;
+            }
+
+            if (IsKeyPressed(KEY_F10))
+            {
+                LuaProfileToggleRequested = true;
+            }
         }
-        World.ResourceHolder.Resources.clear();
+        World.ResourceHolder.Clear();
         CloseWindow();
         World.OnShutdown();
         ExitSignal = true; });
@@ -177,44 +240,62 @@ void DoMain()
 
     LuaRuntime.InitLua();
     LuaRuntime.SetWorld(&World);
+
+    if (LuaProfileOnStart)
+    {
+        LuaRuntime.ToggleProfiler();
+    }
+
     LuaRuntime.RunScript(Helpers::GetProjectDirectory().string() + "lua" + DirSlash + "main.lua");
 
 #if defined(PLATFORM_WEB)
     emscripten_set_main_loop(UpdateDrawFrame, 0, 1);
 #else
 
+    StartFileWatcher();
+
     // Main game loop
     //--------------------------------------------------------------------------------------
-    std::function<bool ()> fileCheckTimer = Timer(500);
-    long lastModTime = GetFileModTime(FinalLibName.c_str());
-
     while (ExitSignal == false)
     {
-        if (fileCheckTimer())
-        {
-            long modTime = GetFileModTime(FinalLibName.c_str());
-            if (modTime != lastModTime)
-            {
-                HotReloadTimer = Timer(500);
-                lastModTime = modTime;
-            }
-
-            fileCheckTimer = Timer(500);
-        }
+        FileWatcher.Update();
 
-        if (HotReloadTimer())
+        // the loader holds on to the CDOs, wait with reloading until it's done
+        if (!SnapshotStreamer.IsLoading() && HotReloadRequested)
         {
             World.RenderThreadMutex.lock();
             LoadGameLib();
             World.RenderThreadMutex.unlock();
         }
 
+        std::string quickSavePath = LibDir + DirSlash + "quicksave.asnp";
+        if (QuickSaveRequested.exchange(false))
+        {
+            SnapshotStreamer.RequestSave(&World, quickSavePath);
+        }
+
+        if (QuickLoadRequested.exchange(false))
+        {
+            SnapshotStreamer.RequestLoad(quickSavePath);
+        }
+
+        SnapshotStreamer.Update(&World);
+
+        if (LuaProfileToggleRequested.exchange(false))
+        {
+            LuaRuntime.ToggleProfiler();
+        }
+
         World.ProcessSystems();
+        LuaRuntime.DoLua();
     }
+
+    FileWatcher.Stop();
 #endif
 
     // De-Initialization
     RenderThread.join();
+    AProfiler::EndCapture();
     LuaRuntime.UnloadLua();
     World.Clear();
     //--------------------------------------------------------------------------------------
@@ -250,51 +331,58 @@ void TryUnloadGameLib()
     }
 }
 
-nlohmann::json _serialized;
-
 void PreHotReload()
 {
     World.OnPreHotReload();
-    const auto &entities = World.GetObjectsByName("AEntity");
-
-    nlohmann::json serialized;
-    serialized["Entities"] = {};
-    for (auto &entity : entities)
-    {
-        serialized["Entities"].push_back(entity->Serialize());
-    }
-
-    _serialized = serialized;
+    World.BeginHotReload();
 }
 
 void PostHotReload()
 {
-    World.Clear();
     RegisterTypes();
     RegisterSystems();
+    LuaRuntime.OnPostHotReload();
+    World.EndHotReload();
 
-    nlohmann::json serialized = _serialized;
-    for (auto &ent : serialized["Entities"])
-    {
-        AEntity *e = World.NewObject_Internal<AEntity>(AName("AEntity"));
+    World.OnPostHotReload();
+    std::cout << "posthotreload" << std::endl;
+}
+
+void StartFileWatcher()
+{
+    std::filesystem::path libFileName = std::filesystem::path(FinalLibName).filename();
 
-        for (auto &comp : ent["Components"])
+    // the lib's directory also gets the temp copies of the lib and saves
+    FileWatcher.Watch(LibDir, false, [libFileName](const std::filesystem::path &path)
+                      {
+        if (path.filename() == libFileName)
         {
-            AComponent *component = World.NewObject_Internal<AComponent>(comp["Name"].get<std::string>());
-            component->Deserialize(comp);
+            HotReloadRequested = true;
+        } });
 
-            e->AddComponent(component);
-        }
+    std::filesystem::path projectDir = Helpers::GetProjectDirectory();
+
+    if (std::filesystem::is_directory(projectDir / "lua"))
+    {
+        FileWatcher.Watch(projectDir / "lua", true, [](const std::filesystem::path &path)
+                          { LuaRuntime.ReloadScript(path); });
     }
 
-    World.OnPostHotReload();
-    std::cout << "posthotreload" << std::endl;
+    // resources are keyed by their path relative to the project
+    if (std::filesystem::is_directory(projectDir / "Assets"))
+    {
+        FileWatcher.Watch(projectDir / "Assets", true, [projectDir](const std::filesystem::path &path)
+                          { World.ResourceHolder.ReloadResource(std::filesystem::relative(path, projectDir).generic_string()); });
+    }
+
+    FileWatcher.Start();
+
+    std::cout << "Watching files " << (FileWatcher.IsUsingInotify() ? "with inotify" : "by polling") << std::endl;
 }
 
 void LoadGameLib()
 {
-    HotReloadTimer = []()
-    { return false; };
+    HotReloadRequested = false;
 
     if (GameLibInitialized)
     {